@@ -0,0 +1,108 @@
+#include "breathing.h"
+
+#ifndef BREATHING_MAX_CHANNELS
+#    define BREATHING_MAX_CHANNELS 8
+#endif
+
+// Milliseconds per phase step. 3 gives the 768 ms cycle of the old
+// (timer / 3) & 0xFF float curve.
+#ifndef BREATHING_STEP_MS
+#    define BREATHING_STEP_MS 3
+#endif
+
+// First quadrant of sin(), scaled to 0-255. The other three quadrants are
+// mirrored from it.
+static const uint8_t PROGMEM quarter_sine[65] = {
+      0,   6,  13,  19,  25,  31,  37,  44,
+     50,  56,  62,  68,  74,  80,  86,  92,
+     98, 103, 109, 115, 120, 126, 131, 136,
+    142, 147, 152, 157, 162, 167, 171, 176,
+    180, 185, 189, 193, 197, 201, 205, 208,
+    212, 215, 219, 222, 225, 228, 231, 233,
+    236, 238, 240, 242, 244, 246, 247, 249,
+    250, 251, 252, 253, 254, 254, 255, 255,
+    255,
+};
+
+static uint8_t  phase = 0;
+static uint8_t  step_remainder = 0;  // ms toward the next step
+static uint16_t last_time = 0;
+static uint8_t  last_phase = 0;
+static bool     started = false;
+static uint8_t  levels[BREATHING_MAX_CHANNELS];
+
+// sin() at a 256-step cycle position, as 255 + sin * 255 (0-510)
+static uint16_t sine_at(uint8_t step) {
+    uint8_t idx = step & 0x3F;
+    if (step & 0x40) {
+        idx = 64 - idx;
+    }
+    uint8_t s = pgm_read_byte(&quarter_sine[idx]);
+    return (step & 0x80) ? 255 - s : 255 + s;
+}
+
+// (sin + 1) / 2. The old float curve took sin(phase / 255 * 2 pi), a cycle
+// of 255 phase steps, so the phase is stretched by 257/256 onto the table's
+// 256 and interpolated between its steps. Rounding matches a floor in both
+// directions, which keeps scaled levels within 1 LSB of the old curve.
+static uint8_t sine_level(uint8_t phase) {
+    uint16_t pos  = (uint16_t)phase * 257;
+    uint8_t  step = pos >> 8;
+    uint8_t  frac = pos & 0xFF;
+    uint16_t a    = sine_at(step);
+    uint16_t b    = sine_at(step + 1);
+    uint16_t s    = b >= a ? a + (((b - a) * frac) >> 8) : a - (((a - b) * frac + 255) >> 8);
+    return (s + 1) >> 1;
+}
+
+static uint8_t triangle_level(uint8_t phase) {
+    uint8_t t = phase + 64;
+    return t < 128 ? (t << 1) | 1 : (255 - t) << 1;
+}
+
+// Quadratic ease in/out over the triangle, so the LED lingers at both ends
+static uint8_t eased_level(uint8_t phase) {
+    uint8_t x = triangle_level(phase);
+    uint8_t j = x < 128 ? x : 255 - x;
+    uint8_t e = ((uint16_t)j * j) >> 7;
+    return x < 128 ? e : 255 - e;
+}
+
+uint8_t breathing_wave_level(breathing_wave wave, uint8_t phase) {
+    switch (wave) {
+    case wave_triangle:
+        return triangle_level(phase);
+    case wave_eased:
+        return eased_level(phase);
+    case wave_sine:
+    default:
+        return sine_level(phase);
+    }
+}
+
+bool breathing_update(void) {
+    uint16_t now = timer_read();
+    // The remainder carries over, so the phase never drifts from the clock.
+    // uint8_t wrap-around is the cycle.
+    uint32_t elapsed = (uint16_t)(now - last_time) + step_remainder;
+    last_time = now;
+    phase += elapsed / BREATHING_STEP_MS;
+    step_remainder = elapsed % BREATHING_STEP_MS;
+
+    if (started && phase == last_phase) {
+        return false;
+    }
+    started = true;
+    last_phase = phase;
+
+    for (uint8_t i = 0; i < breathing_channel_count && i < BREATHING_MAX_CHANNELS; i++) {
+        breathing_wave wave = (breathing_wave)pgm_read_byte(&breathing_channels[i].wave);
+        uint8_t offset = pgm_read_byte(&breathing_channels[i].phase_offset);
+        levels[i] = breathing_wave_level(wave, phase + offset);
+    }
+    return true;
+}
+
+uint8_t breathing_level(uint8_t channel) {
+    return channel < BREATHING_MAX_CHANNELS ? levels[channel] : 255;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+// Shapes the breathing engine can evaluate
+typedef enum {
+    wave_sine,
+    wave_triangle,
+    wave_eased,
+} breathing_wave;
+
+// A breathing channel. Every LED on the same channel shares one level, so
+// each waveform is evaluated once per frame instead of once per LED.
+typedef struct {
+    uint8_t wave;  // breathing_wave, kept to a byte for pgm_read_byte
+    uint8_t phase_offset;
+} breathing_channel;
+
+// Integer breathing engine. The phase advances one step every
+// BREATHING_STEP_MS of timer_read(), one full cycle being 256 steps. Returns
+// false, without touching the levels, if the phase has not moved since the
+// last call, so it is cheap to call once per render chunk.
+bool breathing_update(void);
+
+// Level (0-255) of a channel as of the last breathing_update().
+uint8_t breathing_level(uint8_t channel);
+
+// Evaluates a waveform at an 8-bit phase, peaking at phase 64.
+uint8_t breathing_wave_level(breathing_wave wave, uint8_t phase);
+
+// Scales a color component by a level, value * level / 255 without a divide.
+static inline uint8_t breathing_scale(uint8_t value, uint8_t level) {
+    uint16_t x = (uint16_t)value * level;
+    return (x + (x >> 8)) >> 8;
+}
+
+// To be implemented by the consumer. The channel table, in PROGMEM, and the
+// number of entries in it (at most BREATHING_MAX_CHANNELS).
+extern const breathing_channel breathing_channels[];
+extern const uint8_t breathing_channel_count;
@@ -0,0 +1,126 @@
+#include "chord.h"
+#include <string.h>
+
+#ifndef CHORD_MAX_KEYS
+#    define CHORD_MAX_KEYS 4
+#endif
+
+#define CHORD_POSITIONS (MATRIX_ROWS * MATRIX_COLS)
+
+_Static_assert(CHORD_POSITIONS <= 64, "Key positions must fit in a 64-bit mask");
+
+static uint8_t key_chords[CHORD_POSITIONS];  // Chords each position belongs to
+
+// Chord being assembled
+static uint64_t    pressed = 0;
+static uint8_t     candidates = 0;
+static uint16_t    started;
+static keyrecord_t buffer[CHORD_MAX_KEYS + 1];  // Members, then the event that broke the chord
+static uint8_t     buffered = 0;
+static bool        replaying = false;
+
+// Completed chord whose keys are still down
+static int8_t   active = -1;
+static uint64_t active_keys = 0;
+
+static inline uint64_t chord_keys(uint8_t index) {
+    uint64_t keys;
+    memcpy_P(&keys, &chords[index].keys, sizeof(keys));
+    return keys;
+}
+
+void chord_init(void) {
+    memset(key_chords, 0, sizeof(key_chords));
+    for (uint8_t i = 0; i < chord_count && i < 8; i++) {
+        uint64_t keys = chord_keys(i);
+        for (uint8_t pos = 0; pos < CHORD_POSITIONS; pos++) {
+            if (keys & (1ULL << pos)) key_chords[pos] |= 1 << i;
+        }
+    }
+}
+
+static void reset(void) {
+    pressed    = 0;
+    candidates = 0;
+    buffered   = 0;
+}
+
+// Sends the held back presses on as if no chord had been involved
+static void flush(void) {
+    replaying = true;
+    for (uint8_t i = 0; i < buffered; i++) {
+        process_record(&buffer[i]);
+    }
+    replaying = false;
+    reset();
+}
+
+// Replays the held back presses followed by the event that ended the chord.
+// QMK resolves an event's keycode before process_record_user sees it, so
+// letting it through would resolve it on the layer from before the replayed
+// presses, while its action ran on the layer after them.
+static bool flush_with(keyrecord_t *record) {
+    buffer[buffered++] = *record;
+    flush();
+    return false;
+}
+
+static void fire(uint8_t index) {
+    active      = index;
+    active_keys = pressed;
+    reset();
+    process_chord_event(index, true);
+}
+
+bool process_chord(keyrecord_t *record) {
+    if (replaying) return true;
+
+    keypos_t key = record->event.key;
+    if (key.row >= MATRIX_ROWS || key.col >= MATRIX_COLS) return true;
+    uint8_t  pos = key.row * MATRIX_COLS + key.col;
+    uint64_t bit = 1ULL << pos;
+
+    if (!record->event.pressed) {
+        if (active_keys & bit) {
+            if (active >= 0) {
+                process_chord_event(active, false);
+                active = -1;
+            }
+            active_keys &= ~bit;
+            return false;
+        }
+        if (pressed & bit) return flush_with(record);
+        return true;
+    }
+
+    uint8_t matching = buffered ? candidates & key_chords[pos] : key_chords[pos];
+    if (!matching || buffered == CHORD_MAX_KEYS) {
+        return buffered ? flush_with(record) : true;
+    }
+
+    if (!buffered) started = timer_read();
+    candidates = matching;
+    pressed |= bit;
+    buffer[buffered++] = *record;
+
+    for (uint8_t i = 0; i < chord_count && i < 8; i++) {
+        if ((candidates & (1 << i)) && chord_keys(i) == pressed) {
+            fire(i);
+            break;
+        }
+    }
+    return false;
+}
+
+// Drops the candidates whose timeout has run out, and replays the held back
+// presses once none is left
+void chord_task(void) {
+    if (!buffered) return;
+    uint16_t elapsed = timer_elapsed(started);
+    for (uint8_t i = 0; i < chord_count && i < 8; i++) {
+        if ((candidates & (1 << i)) && elapsed >= pgm_read_byte(&chords[i].timeout)) {
+            candidates &= ~(1 << i);
+        }
+    }
+    if (!candidates) flush();
+}
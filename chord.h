@@ -0,0 +1,40 @@
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+// A chord: keys pressed together, each a CHORD_KEY() bit, and how long
+// after its first key the rest may still arrive
+typedef struct {
+    uint64_t keys;
+    uint8_t  timeout;  // ms
+} chord_t;
+
+#define CHORD_KEY(row, col) (1ULL << ((row) * MATRIX_COLS + (col)))
+
+// Chord engine matching key positions as bitmasks. A per-position index of
+// the chords each key belongs to makes every event O(1): a press narrows the
+// candidate set with one AND and completes a chord when the held keys equal
+// its mask. Presses of member keys are held back while a chord could still
+// complete, and replayed in order as soon as one can't: another key is
+// pressed, a member is released or the timeouts of all remaining candidates
+// have run out. A candidate whose timeout runs out is dropped on its own.
+// The key event that broke the chord is replayed after them, so it resolves
+// on the layer the replayed presses leave active.
+//
+// Returns false if the event was consumed. Call from process_record_user.
+bool process_chord(keyrecord_t *record);
+
+// Applies chord timeouts. Call from housekeeping_task_user.
+void chord_task(void);
+
+// Builds the key index. Call from keyboard_post_init_user.
+void chord_init(void);
+
+// To be implemented by the consumer. The chord table, in PROGMEM, and the
+// number of entries in it (at most 8).
+extern const chord_t chords[];
+extern const uint8_t chord_count;
+
+// To be implemented by the consumer. Called with pressed set when a chord
+// completes, and cleared when the first of its keys is released.
+void process_chord_event(uint8_t index, bool pressed);
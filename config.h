@@ -7,20 +7,29 @@
     #define SPLIT_LAYER_STATE_ENABLE
     #define SPLIT_TRANSPORT_MIRROR
 
-    // Enable reactive effects
+    // Keypress tracking for the reactive keys on layer 0
     #define RGB_MATRIX_KEYPRESSES
-    #define RGB_MATRIX_FRAMEBUFFER_EFFECTS
 
-    // Enable specific effects
-    #define ENABLE_RGB_MATRIX_SOLID_COLOR
-    #define ENABLE_RGB_MATRIX_BREATHING
-    #define ENABLE_RGB_MATRIX_SOLID_REACTIVE_SIMPLE
+    // The layer overlay in rgb_matrix_user.inc is the only effect used, so
+    // no built-in effects are enabled
+    #define RGB_MATRIX_DEFAULT_MODE RGB_MATRIX_CUSTOM_LAYER_OVERLAY
 
     // Performance settings
     #define RGB_MATRIX_LED_PROCESS_LIMIT (RGB_MATRIX_LED_COUNT + 4) / 5
     #define RGB_MATRIX_LED_FLUSH_LIMIT 16
+    // The overlay adapts its own per-chunk work to stay within this budget
+    // #define RGB_RENDER_BUDGET_US 100
+    // #define RGB_BREATH_INTERVAL_MAX 32
+    // #define RGB_LAYER_FADE_MS 150  // Overlay crossfade between layers, 0 to disable
+    // #define RGB_MODE_DEBOUNCE_MS 20  // Layer flicker window for mode/HSV/speed changes
     // RGB_MATRIX_MAXIMUM_BRIGHTNESS is defined in info.json as 120
 
+    // Overlay power governor, per half. Scales the overlay down when its
+    // estimated peak draw goes over budget. Without a budget it allows what
+    // a stock effect draws at RGB_MATRIX_MAXIMUM_BRIGHTNESS.
+    // #define RGB_GOVERNOR_BUDGET_MA 250
+    // #define RGB_GOVERNOR_MA_PER_CHANNEL 20
+
     // Default settings - Reduced for power safety
     #define RGB_MATRIX_DEFAULT_VAL 80  // 66% brightness for layer 0
     #define RGB_MATRIX_HUE_STEP 8
@@ -28,20 +37,49 @@
     #define RGB_MATRIX_VAL_STEP 8
     #define RGB_MATRIX_SPD_STEP 10
 
-    // // Disable RGB when suspended
-    // #define RGB_DISABLE_WHEN_USB_SUSPENDED
-    //
-    // // Add timeout to save power
-    // #define RGB_MATRIX_TIMEOUT 300000  // 5 minutes
+    // Disable RGB when suspended
+    #define RGB_DISABLE_WHEN_USB_SUSPENDED
+
+    // Idle tiers replace RGB_MATRIX_TIMEOUT: dim, then off with split sync
+    // paused, then a slower scan. The slave needs the master's activity
+    #define SPLIT_ACTIVITY_ENABLE
+    // #define IDLE_DIM_MS 30000     // 30 seconds
+    // #define IDLE_OFF_MS 300000    // 5 minutes
+    // #define IDLE_DEEP_MS 1800000  // 30 minutes
 #endif
 
-// Enable custom split data sync for rgb_enabled variable and OSM states
-#define SPLIT_TRANSACTION_IDS_USER USER_SYNC_RGB_ENABLED, USER_SYNC_OSM_STATE
+// Enable custom split data sync for rgb_enabled variable and OSM states,
+// packed into a single versioned state word. The heatmap adds a
+// transaction for its levels
+#ifdef HEATMAP_ENABLE
+#    define SPLIT_TRANSACTION_IDS_USER USER_SYNC_STATE, USER_SYNC_HEATMAP
+#else
+#    define SPLIT_TRANSACTION_IDS_USER USER_SYNC_STATE
+#endif
+// #define SPLIT_SYNC_HEARTBEAT_MS 1000  // Resend unchanged state this often
+// #define SPLIT_SYNC_RETRY_MS 10        // Retry a failed transaction after
 
 #define DYNAMIC_KEYMAP_LAYER_COUNT 6
 
-// // Tapping term for tap/hold keys (ESC/Shift)
-// #define TAPPING_TERM 150
-// // Optional: Add settings for better mod behavior
-// #define PERMISSIVE_HOLD
-// #define HOLD_ON_OTHER_KEY_PRESS
+// Two heatmap slots: 2 * (2 + 4 * 48 + 128) bytes
+#ifdef HEATMAP_ENABLE
+#    define EECONFIG_USER_DATA_SIZE 644
+#endif
+
+// Per-key debounce time in ms (1-127), see per_key_debounce.h
+// #define DEBOUNCE 5
+
+// Poll at 1000 Hz so reports leave as soon as a scan produces them
+#define USB_POLLING_INTERVAL_MS 1
+
+// Mouse engine tuning, see mouse_engine.h
+// #define MOUSE_ENGINE_INTERVAL_MS 8                    // Report interval, 1-64
+// #define MOUSE_ENGINE_CURSOR_SPEEDS {900, 200, 600, 1800} // px/s: default, ACL0-2
+// #define MOUSE_ENGINE_WHEEL_SPEEDS {12, 4, 10, 30}     // Detents/s: default, ACL0-2
+// #define MOUSE_ENGINE_EASE 4                           // Easing per ms, out of 256
+// #define POINTING_DEVICE_HIRES_SCROLL_ENABLE           // Wheel in fractions of a detent
+
+// Tap-hold resolver for the ESC/Shift key, with TAP_HOLD_ENABLE. Replaces
+// TAPPING_TERM and PERMISSIVE_HOLD
+// #define TAP_HOLD_TERM 150       // Hold when still undecided after this
+// #define TAP_HOLD_STREAK_MS 100  // Tap at once when pressed this soon after another key
@@ -0,0 +1,243 @@
+#include "heatmap.h"
+#include "eeconfig.h"
+#include "eeprom.h"
+#include "transactions.h"
+#include <stddef.h>
+#include <string.h>
+
+#ifndef HEATMAP_FLUSH_INTERVAL_MS
+#    define HEATMAP_FLUSH_INTERVAL_MS 600000  // At most one flush per 10 minutes
+#endif
+#ifndef HEATMAP_FLUSH_IDLE_MS
+#    define HEATMAP_FLUSH_IDLE_MS 5000  // Only start one after this long without input
+#endif
+#ifndef HEATMAP_FLUSH_BYTES_PER_PASS
+#    define HEATMAP_FLUSH_BYTES_PER_PASS 4
+#endif
+#ifndef HEATMAP_SYNC_RETRY_MS
+#    define HEATMAP_SYNC_RETRY_MS 10
+#endif
+
+_Static_assert((HEATMAP_BIGRAMS & (HEATMAP_BIGRAMS - 1)) == 0, "HEATMAP_BIGRAMS must be a power of two");
+_Static_assert(HEATMAP_KEYS < 255, "Key indices must fit in a byte");
+
+typedef struct __attribute__((packed)) {
+    uint8_t   sequence;
+    uint8_t   checksum;
+    heatmap_t counters;
+} heatmap_slot_t;
+
+_Static_assert(EECONFIG_USER_DATA_SIZE >= 2 * sizeof(heatmap_slot_t), "EECONFIG_USER_DATA_SIZE is too small for two heatmap slots");
+
+// Levels of one layer for the slave, 25 bytes with the default 48 keys,
+// inside the 32-byte RPC buffer
+typedef struct __attribute__((packed)) {
+    uint8_t layer;
+    uint8_t levels[(HEATMAP_KEYS + 1) / 2];  // 4 bits per key, even keys in the low nibble
+} heatmap_sync_t;
+
+#define SLOT_ADDR(slot) ((uint8_t *)EECONFIG_USER_DATABLOCK + (slot) * sizeof(heatmap_slot_t))
+
+// Fresh EEPROM, all 0x00 or all 0xFF, never checks out
+#define CHECKSUM_SEED 0xA5
+
+static heatmap_t heatmap;
+static uint8_t   layer_max[HEATMAP_LAYERS];
+static uint8_t   prev_key = 0xFF;
+static bool      dirty = false;
+
+// Flush in progress
+static bool     flushing = false;
+static uint8_t  flush_slot = 0;  // Slot being written, the older one
+static uint8_t  sequence = 0;    // Of the newest slot
+static uint16_t flush_offset;
+static uint8_t  flush_sum;
+static uint32_t last_flush = 0;
+
+// Master side: layer waiting to be sent, or -1
+static int8_t   sync_layer = -1;
+static uint16_t sync_last_try;
+
+// Slave side
+static heatmap_sync_t synced = {.layer = 0xFF};
+static uint8_t        generation = 0;
+
+static void halve(uint8_t *counters, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        counters[i] >>= 1;
+    }
+}
+
+static void update_layer_max(uint8_t layer) {
+    uint8_t max = 0;
+    for (uint8_t i = 0; i < HEATMAP_KEYS; i++) {
+        if (heatmap.keys[layer][i] > max) max = heatmap.keys[layer][i];
+    }
+    layer_max[layer] = max;
+}
+
+static bool slot_valid(uint8_t slot) {
+    const uint8_t *addr = SLOT_ADDR(slot);
+    uint8_t sum = CHECKSUM_SEED + eeprom_read_byte(addr);
+    for (uint16_t i = offsetof(heatmap_slot_t, counters); i < sizeof(heatmap_slot_t); i++) {
+        sum += eeprom_read_byte(addr + i);
+    }
+    return sum == eeprom_read_byte(addr + offsetof(heatmap_slot_t, checksum));
+}
+
+static void heatmap_sync_handler(uint8_t in_buflen, const void *in_data, uint8_t out_buflen, void *out_data) {
+    if (in_buflen < sizeof(synced)) return;
+    memcpy(&synced, in_data, sizeof(synced));
+    generation++;
+}
+
+void heatmap_init(void) {
+    transaction_register_rpc(USER_SYNC_HEATMAP, heatmap_sync_handler);
+
+    bool valid[2] = {slot_valid(0), slot_valid(1)};
+    uint8_t seq[2] = {eeprom_read_byte(SLOT_ADDR(0)), eeprom_read_byte(SLOT_ADDR(1))};
+
+    int8_t newest = -1;
+    if (valid[0] && valid[1]) {
+        newest = (int8_t)(seq[1] - seq[0]) > 0 ? 1 : 0;
+    } else if (valid[0] || valid[1]) {
+        newest = valid[0] ? 0 : 1;
+    }
+
+    if (newest >= 0) {
+        eeprom_read_block(&heatmap, SLOT_ADDR(newest) + offsetof(heatmap_slot_t, counters), sizeof(heatmap));
+        sequence   = seq[newest];
+        flush_slot = newest ^ 1;
+    }
+    for (uint8_t layer = 0; layer < HEATMAP_LAYERS; layer++) {
+        update_layer_max(layer);
+    }
+}
+
+void heatmap_record(uint8_t layer, uint8_t row, uint8_t col) {
+    if (layer >= HEATMAP_LAYERS || row >= MATRIX_ROWS || col >= MATRIX_COLS) {
+        prev_key = 0xFF;
+        return;
+    }
+    uint8_t key = row * MATRIX_COLS + col;
+
+    uint8_t count = ++heatmap.keys[layer][key];
+    if (count == 0xFF) {
+        halve(heatmap.keys[layer], HEATMAP_KEYS);
+        layer_max[layer] >>= 1;
+        count >>= 1;
+    }
+    if (count > layer_max[layer]) layer_max[layer] = count;
+
+    if (prev_key != 0xFF) {
+        uint8_t bucket = HEATMAP_BIGRAM_HASH(prev_key, key);
+        if (++heatmap.bigrams[bucket] == 0xFF) {
+            halve(heatmap.bigrams, HEATMAP_BIGRAMS);
+        }
+    }
+    prev_key = key;
+    dirty = true;
+}
+
+static void flush_start(void) {
+    flushing     = true;
+    dirty        = false;
+    flush_offset = 0;
+    flush_sum    = CHECKSUM_SEED + (uint8_t)(sequence + 1);
+}
+
+// Counters that change mid-flush are written as they are when reached; the
+// checksum covers the bytes actually written, so the slot stays consistent
+static void flush_step(void) {
+    const uint8_t *src  = (const uint8_t *)&heatmap;
+    uint8_t       *addr = SLOT_ADDR(flush_slot) + offsetof(heatmap_slot_t, counters);
+    for (uint8_t i = 0; i < HEATMAP_FLUSH_BYTES_PER_PASS && flush_offset < sizeof(heatmap); i++, flush_offset++) {
+        uint8_t value = src[flush_offset];
+        eeprom_update_byte(addr + flush_offset, value);
+        flush_sum += value;
+    }
+    if (flush_offset < sizeof(heatmap)) return;
+
+    // The header goes last, so an interrupted flush leaves the slot invalid
+    // and the other one in place
+    sequence++;
+    eeprom_update_byte(SLOT_ADDR(flush_slot) + offsetof(heatmap_slot_t, checksum), flush_sum);
+    eeprom_update_byte(SLOT_ADDR(flush_slot), sequence);
+    flush_slot ^= 1;
+    flushing   = false;
+    last_flush = timer_read32();
+}
+
+static uint8_t count_level(uint8_t layer, uint8_t key) {
+    if (!layer_max[layer]) return 0;
+    return (uint16_t)heatmap.keys[layer][key] * 255 / layer_max[layer];
+}
+
+static void sync_step(void) {
+    if (sync_layer < 0 || timer_elapsed(sync_last_try) < HEATMAP_SYNC_RETRY_MS) return;
+
+    heatmap_sync_t m2s = {.layer = sync_layer};
+    for (uint8_t key = 0; key < HEATMAP_KEYS; key++) {
+        m2s.levels[key >> 1] |= (count_level(sync_layer, key) >> 4) << ((key & 1) * 4);
+    }
+    sync_last_try = timer_read();
+    if (transaction_rpc_send(USER_SYNC_HEATMAP, sizeof(m2s), &m2s)) {
+        sync_layer = -1;
+    }
+}
+
+void heatmap_sync(uint8_t layer) {
+    if (layer >= HEATMAP_LAYERS) return;
+    sync_layer    = layer;
+    sync_last_try = timer_read() - HEATMAP_SYNC_RETRY_MS;
+}
+
+uint8_t heatmap_generation(void) {
+    return generation;
+}
+
+void heatmap_task(void) {
+    sync_step();
+    if (flushing) {
+        flush_step();
+    } else if (dirty && timer_elapsed32(last_flush) >= HEATMAP_FLUSH_INTERVAL_MS && last_input_activity_elapsed() >= HEATMAP_FLUSH_IDLE_MS) {
+        flush_start();
+    }
+}
+
+uint8_t heatmap_level(uint8_t layer, uint8_t row, uint8_t col) {
+    if (layer >= HEATMAP_LAYERS || row >= MATRIX_ROWS || col >= MATRIX_COLS) return 0;
+    uint8_t key = row * MATRIX_COLS + col;
+    if (!is_keyboard_master()) {
+        if (layer != synced.layer) return 0;
+        return ((synced.levels[key >> 1] >> ((key & 1) * 4)) & 0x0F) * 17;
+    }
+    return count_level(layer, key);
+}
+
+bool heatmap_raw_hid(uint8_t *data, uint8_t length) {
+    switch (data[0]) {
+    case HEATMAP_CMD_READ: {
+        if (length < 5) return false;
+        uint16_t offset = data[1] | (uint16_t)data[2] << 8;
+        uint8_t  count  = 0;
+        if (offset < sizeof(heatmap)) {
+            count = length - 4;
+            if (count > sizeof(heatmap) - offset) count = sizeof(heatmap) - offset;
+            memcpy(&data[4], (const uint8_t *)&heatmap + offset, count);
+        }
+        data[3] = count;
+        return true;
+    }
+    case HEATMAP_CMD_RESET:
+        memset(&heatmap, 0, sizeof(heatmap));
+        memset(layer_max, 0, sizeof(layer_max));
+        dirty = true;
+        return true;
+    case HEATMAP_CMD_FLUSH:
+        if (!flushing) flush_start();
+        return true;
+    default:
+        return false;
+    }
+}
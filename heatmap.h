@@ -0,0 +1,72 @@
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+// Per-key press counts for each typing layer, plus hashed bigram counts
+// across them, for tuning the layout from real use. Counters are 8-bit and
+// saturating: when one reaches 255 every counter in its table is halved, so
+// the ratios survive and nothing wraps. Recording a press is O(1) outside
+// the rare halving.
+//
+// Counters are kept in two EEPROM slots in the user datablock and written
+// to the older one, a few bytes per housekeeping pass while the keyboard is
+// idle, so a flush never blocks the scan loop and each slot takes half the
+// writes. A slot is valid when its checksum matches; the newest valid one is
+// loaded at boot.
+//
+// Only the master counts presses. For showing the heatmap on both halves,
+// heatmap_sync() sends one layer's levels to the slave at 4 bits per key.
+
+#ifndef HEATMAP_LAYERS
+#    define HEATMAP_LAYERS 4  // Layers 0-3; the gaming layers aren't tracked
+#endif
+#ifndef HEATMAP_BIGRAMS
+#    define HEATMAP_BIGRAMS 128  // Buckets, power of two
+#endif
+
+#define HEATMAP_KEYS (MATRIX_ROWS * MATRIX_COLS)
+
+// Bucket of the bigram between two key indices (row * MATRIX_COLS + col).
+// The host applies the same hash to its candidate bigrams.
+#define HEATMAP_BIGRAM_HASH(a, b) (((uint16_t)(a) * 37 + (b)) & (HEATMAP_BIGRAMS - 1))
+
+typedef struct {
+    uint8_t keys[HEATMAP_LAYERS][HEATMAP_KEYS];
+    uint8_t bigrams[HEATMAP_BIGRAMS];
+} heatmap_t;
+
+// Raw HID commands. Replies echo the command byte.
+//   HEATMAP_CMD_READ, offset (u16) -> byte count (u8), bytes of heatmap_t
+//   HEATMAP_CMD_RESET               -> clears every counter
+//   HEATMAP_CMD_FLUSH               -> starts writing to EEPROM now
+enum heatmap_commands {
+    HEATMAP_CMD_READ = 0x68,
+    HEATMAP_CMD_RESET,
+    HEATMAP_CMD_FLUSH,
+};
+
+// Loads the newest valid slot. Call from keyboard_post_init_user.
+void heatmap_init(void);
+
+// Counts a key press on layer. Call from process_record_user.
+void heatmap_record(uint8_t layer, uint8_t row, uint8_t col);
+
+// Writes pending counts to EEPROM in small steps. Call from
+// housekeeping_task_user.
+void heatmap_task(void);
+
+// Press count of a key relative to the busiest key on its layer, 0-255. On
+// the slave, the level last synced for that layer, in steps of 17.
+uint8_t heatmap_level(uint8_t layer, uint8_t row, uint8_t col);
+
+// Sends the levels of a layer to the slave. Call on the master when the
+// heatmap comes into view; heatmap_task sends it and retries until it goes
+// through.
+void heatmap_sync(uint8_t layer);
+
+// Changes on the slave whenever new levels arrive, so anything drawn from
+// heatmap_level() knows to redraw
+uint8_t heatmap_generation(void);
+
+// Handles a raw HID request in place. Returns false for unknown commands.
+bool heatmap_raw_hid(uint8_t *data, uint8_t length);
@@ -1,6 +1,20 @@
 #include QMK_KEYBOARD_H
 #include "oneshot.h"
-#include "transactions.h"
+#include "breathing.h"
+#include "split_sync.h"
+#include "macro_queue.h"
+#include "chord.h"
+#include "mouse_engine.h"
+#include "per_key_debounce.h"
+#include "report_batch.h"
+#ifdef TAP_HOLD_ENABLE
+#    include "tap_hold.h"
+#endif
+#include "perf_stats.h"
+#ifdef HEATMAP_ENABLE
+#    include "heatmap.h"
+#endif
+#include <string.h>
 
 // ============================================================================
 // CUSTOM KEYCODES
@@ -17,9 +31,18 @@ enum custom_keycodes {
     GAMING_MODE,
     DEFAULT_MODE,
     ARROW_R,
-    ARROW_L
+    ARROW_L,
+
+    // Tap-hold keys, resolved by tap_hold.c
+    TH_ESC
 };
 
+#ifdef TAP_HOLD_ENABLE
+#    define HR_ESC TH_ESC  // Escape on tap, Shift on hold
+#else
+#    define HR_ESC KC_ESC
+#endif
+
 // ============================================================================
 // SPLIT KEYBOARD SYNC SETUP
 // ============================================================================
@@ -34,84 +57,57 @@ static user_runtime_config_t user_state = {
     .rgb_enabled = true
 };
 
-// Slave side handler - receives data from master
-void user_sync_rgb_enabled_slave_handler(uint8_t in_buflen, const void* in_data, uint8_t out_buflen, void* out_data) {
-    const user_runtime_config_t *m2s = (const user_runtime_config_t*)in_data;
-    user_state.rgb_enabled = m2s->rgb_enabled;
-}
-
 // ============================================================================
 // STATE VARIABLES
 // ============================================================================
 
-// One-shot modifier states
-oneshot_state os_shft_state = os_up_unqueued;
-oneshot_state os_ctrl_state = os_up_unqueued;
-oneshot_state os_alt_state = os_up_unqueued;
-oneshot_state os_cmd_state = os_up_unqueued;
+// One-shot modifiers, resolved together by update_oneshot_mods. The order
+// matches OS_SHFT..OS_CMD, so an entry's index is its slot.
+const oneshot_mod PROGMEM oneshot_mods[] = {
+    {OS_SHFT, MOD_BIT(KC_LSFT)},
+    {OS_CTRL, MOD_BIT(KC_LCTL)},
+    {OS_ALT,  MOD_BIT(KC_LALT)},
+    {OS_CMD,  MOD_BIT(KC_LGUI)},
+};
+const uint8_t oneshot_mod_count = sizeof(oneshot_mods) / sizeof(oneshot_mods[0]);
+
+// Returns the oneshot slot driven by a trigger keycode, or 255 if none
+uint8_t get_oneshot_slot(uint16_t keycode) {
+    if (keycode >= OS_SHFT && keycode <= OS_CMD) {
+        return keycode - OS_SHFT;
+    }
+    return 255;
+}
+
+// All four oneshot states packed two bits each, slot 0 in the low bits
+uint8_t get_oneshot_packed(void) {
+    uint8_t packed = 0;
+    for (uint8_t i = 0; i < oneshot_mod_count; i++) {
+        packed |= (get_oneshot_state(i) & 0x3) << (i * 2);
+    }
+    return packed;
+}
+
+// State word synced to the slave: rgb_enabled in bit 0, the packed oneshot
+// states in the high byte
+uint16_t get_user_sync_state(void) {
+    return (user_state.rgb_enabled ? 1 : 0) | ((uint16_t)get_oneshot_packed() << 8);
+}
+
+// Slave side - applies the state word received from master
+void split_sync_apply(uint16_t state) {
+    user_state.rgb_enabled = state & 1;
+    for (uint8_t i = 0; i < oneshot_mod_count; i++) {
+        set_oneshot_state(i, (oneshot_state)((state >> (8 + i * 2)) & 0x3));
+    }
+}
 
 // Helper function to check if any oneshot mod is queued (waiting for next key)
 bool is_oneshot_active(void) {
-    return os_shft_state == os_up_queued ||
-           os_ctrl_state == os_up_queued ||
-           os_alt_state == os_up_queued ||
-           os_cmd_state == os_up_queued;
-}
-
-void update_oneshot(
-    oneshot_state *state,
-    uint16_t mod,
-    uint16_t trigger,
-    uint16_t keycode,
-    keyrecord_t *record
-) {
-    if (keycode == trigger) {
-        if (record->event.pressed) {
-            // Trigger keydown
-            if (*state == os_up_unqueued) {
-                register_code(mod);
-            }
-            *state = os_down_unused;
-        } else {
-            // Trigger keyup
-            switch (*state) {
-            case os_down_unused:
-                // If we didn't use the mod while trigger was held, queue it.
-                *state = os_up_queued;
-                break;
-            case os_down_used:
-                // If we did use the mod while trigger was held, unregister it.
-                *state = os_up_unqueued;
-                unregister_code(mod);
-                break;
-            default:
-                break;
-            }
-        }
-    } else {
-        if (record->event.pressed) {
-            if (is_oneshot_cancel_key(keycode) && *state != os_up_unqueued) {
-                // Cancel oneshot on designated cancel keydown.
-                *state = os_up_unqueued;
-                unregister_code(mod);
-            }
-        } else {
-            if (!is_oneshot_ignored_key(keycode)) {
-                // On non-ignored keyup, consider the oneshot used.
-                switch (*state) {
-                case os_down_unused:
-                    *state = os_down_used;
-                    break;
-                case os_up_queued:
-                    *state = os_up_unqueued;
-                    unregister_code(mod);
-                    break;
-                default:
-                    break;
-                }
-            }
-        }
+    for (uint8_t i = 0; i < oneshot_mod_count; i++) {
+        if (get_oneshot_state(i) == os_up_queued) return true;
     }
+    return false;
 }
 
 // ============================================================================
@@ -154,6 +150,31 @@ uint8_t get_led_from_matrix(uint8_t row, uint8_t col) {
     return 255;
 }
 
+// Reverse of the two tables above: the key under every LED, as row << 4 | col
+// with rows counted across both halves, or LED_UNDERGLOW. Lets the renderer
+// walk an LED range directly instead of the whole matrix.
+#define LED_KEY(row, col) ((uint8_t)((row) << 4 | (col)))
+#define LED_KEY_ROW(key) ((key) >> 4)
+#define LED_KEY_COL(key) ((key) & 0x0F)
+#define LED_UNDERGLOW 0xFF
+
+const uint8_t PROGMEM led_to_key[] = {
+    // Left underglow, LEDs 0-5
+    LED_UNDERGLOW, LED_UNDERGLOW, LED_UNDERGLOW, LED_UNDERGLOW, LED_UNDERGLOW, LED_UNDERGLOW,
+    // Left keys, LEDs 6-26
+    LED_KEY(3, 5), LED_KEY(2, 5), LED_KEY(1, 5), LED_KEY(0, 5), LED_KEY(0, 4), LED_KEY(1, 4),
+    LED_KEY(2, 4), LED_KEY(3, 4), LED_KEY(3, 3), LED_KEY(2, 3), LED_KEY(1, 3), LED_KEY(0, 3),
+    LED_KEY(0, 2), LED_KEY(1, 2), LED_KEY(2, 2), LED_KEY(2, 1), LED_KEY(1, 1), LED_KEY(0, 1),
+    LED_KEY(0, 0), LED_KEY(1, 0), LED_KEY(2, 0),
+    // Right underglow, LEDs 27-32
+    LED_UNDERGLOW, LED_UNDERGLOW, LED_UNDERGLOW, LED_UNDERGLOW, LED_UNDERGLOW, LED_UNDERGLOW,
+    // Right keys, LEDs 33-53
+    LED_KEY(7, 3), LED_KEY(6, 0), LED_KEY(5, 0), LED_KEY(4, 0), LED_KEY(4, 1), LED_KEY(5, 1),
+    LED_KEY(6, 1), LED_KEY(7, 4), LED_KEY(7, 5), LED_KEY(6, 2), LED_KEY(5, 2), LED_KEY(4, 2),
+    LED_KEY(4, 3), LED_KEY(5, 3), LED_KEY(6, 3), LED_KEY(6, 4), LED_KEY(5, 4), LED_KEY(4, 4),
+    LED_KEY(4, 5), LED_KEY(5, 5), LED_KEY(6, 5),
+};
+
 // ============================================================================
 // COLOR CONFIGURATION
 // ============================================================================
@@ -237,8 +258,14 @@ uint8_t get_led_from_matrix(uint8_t row, uint8_t col) {
 #define LAYER_IND_S     255
 #define LAYER_IND_V     120
 
-// Breathing effect speed
-#define BREATHING_SPEED 70
+// Heatmap shown on layer 3, when HEATMAP_ENABLE is on. Hue runs from
+// HEATMAP_COLD_H for unused keys down to red for the busiest one.
+#define HEATMAP_VIEW_LAYER  0
+#define HEATMAP_COLD_H      170
+#define HEATMAP_V           100
+
+// Fade speed of the reactive keys on layer 0
+#define REACTIVE_SPEED 70
 
 // ============================================================================
 // KEYMAP DEFINITION
@@ -248,7 +275,7 @@ const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
     // Layer 0: Colemak-DH (Default)
     [0] = LAYOUT_split_3x6_3(
       KC_TAB,    KC_Q,    KC_W,    KC_F,    KC_P,    KC_B,                         KC_J,    KC_L,    KC_U,    KC_Y, KC_SCLN,  KC_DEL,
-      KC_ESC, KC_A,  KC_R,    KC_S,    KC_T,    KC_G,                         KC_M,    KC_N,    KC_E,    KC_I,    KC_O,  KC_ENT,
+      HR_ESC, KC_A,  KC_R,    KC_S,    KC_T,    KC_G,                         KC_M,    KC_N,    KC_E,    KC_I,    KC_O,  KC_ENT,
       KC_LCTL,    KC_Z,    KC_X,    KC_C,    KC_D,    KC_V,                         KC_K,    KC_H, KC_COMM,  KC_DOT, KC_SLSH, KC_QUOT,
                                           KC_LALT,   MO(1),  KC_SPC,    OS_SHFT,   MO(2), KC_BSPC
     ),
@@ -354,24 +381,65 @@ bool is_oneshot_ignored_key(uint16_t keycode) {
     }
 }
 
+// ============================================================================
+// TAP-HOLD KEYS
+// ============================================================================
+
+#ifdef TAP_HOLD_ENABLE
+const tap_hold_key PROGMEM tap_hold_keys[] = {
+    {TH_ESC, KC_ESC, KC_LSFT},
+};
+const uint8_t tap_hold_key_count = sizeof(tap_hold_keys) / sizeof(tap_hold_keys[0]);
+#endif
+
+// ============================================================================
+// CHORDS
+// ============================================================================
+
+enum chord_names {
+    CHORD_LAYER3,
+};
+
+const chord_t PROGMEM chords[] = {
+    // Both layer thumbs, in either order
+    [CHORD_LAYER3] = {CHORD_KEY(3, 4) | CHORD_KEY(7, 4), 30},
+};
+const uint8_t chord_count = sizeof(chords) / sizeof(chords[0]);
+
+void process_chord_event(uint8_t index, bool pressed) {
+    switch (index) {
+        case CHORD_LAYER3:
+            if (pressed) {
+                layer_on(3);
+            } else {
+                layer_off(3);
+            }
+            break;
+    }
+}
+
+// ============================================================================
+// DEBOUNCE
+// ============================================================================
+
+// The gaming layers (GAMING_MODE moves to layer 4) take presses on the first
+// scan. Typing keeps symmetric debounce against chatter.
+debounce_mode debounce_mode_for_layer(uint8_t layer) {
+    return layer >= 4 ? debounce_eager : debounce_symmetric;
+}
+
 // ============================================================================
 // CUSTOM KEYCODE PROCESSING
 // ============================================================================
 
-bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+static bool process_record_keymap(uint16_t keycode, keyrecord_t *record) {
     // Process one-shot modifiers
-    update_oneshot(&os_shft_state, KC_LSFT, OS_SHFT, keycode, record);
-    update_oneshot(&os_ctrl_state, KC_LCTL, OS_CTRL, keycode, record);
-    update_oneshot(&os_alt_state, KC_LALT, OS_ALT, keycode, record);
-    update_oneshot(&os_cmd_state, KC_LGUI, OS_CMD, keycode, record);
+    update_oneshot_mods(keycode, record);
 
     switch (keycode) {
         case RGB_TOG_CUSTOM:
             if (record->event.pressed) {
                 user_state.rgb_enabled = !user_state.rgb_enabled;
-                if (!user_state.rgb_enabled) {
-                    rgb_matrix_set_color_all(0, 0, 0);
-                }
             }
             return false;
 
@@ -389,13 +457,13 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
 
         case ARROW_R:  // ->
             if (record->event.pressed) {
-                SEND_STRING("->");
+                MACRO_QUEUE_STRING("->");
             }
             return false;
 
         case ARROW_L:  // <-
             if (record->event.pressed) {
-                SEND_STRING("<-");
+                MACRO_QUEUE_STRING("<-");
             }
             return false;
     }
@@ -403,19 +471,100 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
     return true;
 }
 
+// Basic keycodes can't start a oneshot or hit the custom keycode switch, so
+// with no oneshot engaged there is nothing for the keymap to do. This holds
+// on every layer; on the gaming layers it is every key except DEFAULT_MODE.
+static inline bool is_fast_path_key(uint16_t keycode) {
+    return keycode < SAFE_RANGE && !is_oneshot_engaged();
+}
+
+bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+    PERF_COUNT(PERF_COUNT_KEY_EVENTS);
+    // Chords only start on the typing layer, which keeps them out of the
+    // gaming layers. Releases always go through to end an active one.
+    if ((get_highest_layer(layer_state) == 0 || !record->event.pressed) && !process_chord(record)) {
+        return false;
+    }
+#ifdef TAP_HOLD_ENABLE
+    if (!process_tap_hold(keycode, record)) return false;
+#endif
+#ifdef HEATMAP_ENABLE
+    if (record->event.pressed) {
+        PERF_BEGIN(PERF_HEATMAP);
+        heatmap_record(get_highest_layer(layer_state), record->event.key.row, record->event.key.col);
+        PERF_END(PERF_HEATMAP);
+    }
+#endif
+    // Mouse keycodes are basic keycodes, so catch them before the fast path
+    if (!process_mouse_engine(keycode, record)) return false;
+    PERF_BEGIN(PERF_PROCESS_RECORD);
+    bool result = is_fast_path_key(keycode) || process_record_keymap(keycode, record);
+    PERF_END(PERF_PROCESS_RECORD);
+    // No key action follows to carry batched mods, so send them now
+    if (!result) report_batch_flush();
+    return result;
+}
+
+void post_process_record_user(uint16_t keycode, keyrecord_t *record) {
+    report_batch_flush();
+}
+
+// ============================================================================
+// RAW HID
+// ============================================================================
+
+#ifdef RAW_ENABLE
+#    ifdef RGB_MATRIX_ENABLE
+static bool rgb_mode_raw_hid(uint8_t *data, uint8_t length);
+#    endif
+
+// Host commands for reading back the instrumentation counters. Unknown
+// commands are answered with 0xFF in the first byte.
+void raw_hid_receive(uint8_t *data, uint8_t length) {
+    bool handled = false;
+#    ifdef PERF_STATS_ENABLE
+    handled = perf_stats_raw_hid(data, length);
+#    endif
+    handled = handled || split_sync_raw_hid(data, length);
+#    ifdef HEATMAP_ENABLE
+    handled = handled || heatmap_raw_hid(data, length);
+#    endif
+#    ifdef RGB_MATRIX_ENABLE
+    handled = handled || rgb_mode_raw_hid(data, length);
+#    endif
+    if (!handled) {
+        data[0] = 0xFF;
+    }
+    raw_hid_send(data, length);
+}
+#endif
+
 // ============================================================================
 // RGB MATRIX EFFECTS
 // ============================================================================
 
 #ifdef RGB_MATRIX_ENABLE
 
-// Breathing effect helper
-static uint8_t breathing_brightness(uint8_t base_val, uint16_t offset_time) {
-    uint16_t elapsed = timer_elapsed(offset_time);
-    uint8_t phase = (elapsed / 3) & 0xFF;  // Much faster cycle
-    float breathing = (sin((phase / 255.0) * 2 * 3.14159) + 1.0) / 2.0;
-    return (uint8_t)(base_val * breathing);
-}
+// Breathing channels, one per breathing key category. Each channel is
+// evaluated once per frame and shared by every LED on it; give categories
+// different waves or phase offsets here to stagger them.
+enum breathing_channel_ids {
+    BREATH_L1_BRACKETS,
+    BREATH_L2_NUMBERS,
+    BREATH_L2_ARROWS,
+    BREATH_L3_MODES,
+    BREATH_L3_OTHERS,
+    BREATH_NONE = 0xFF
+};
+
+const breathing_channel PROGMEM breathing_channels[] = {
+    [BREATH_L1_BRACKETS] = {wave_sine, 0},
+    [BREATH_L2_NUMBERS]  = {wave_sine, 0},
+    [BREATH_L2_ARROWS]   = {wave_sine, 0},
+    [BREATH_L3_MODES]    = {wave_sine, 0},
+    [BREATH_L3_OTHERS]   = {wave_sine, 0},
+};
+const uint8_t breathing_channel_count = sizeof(breathing_channels) / sizeof(breathing_channels[0]);
 
 // ============================================================================
 // KEY CATEGORIZATION
@@ -439,21 +588,6 @@ bool is_layer0_mod(uint8_t row, uint8_t col) {
     return false;
 }
 
-uint16_t get_layer1_keycode(uint8_t row, uint8_t col) {
-    const uint16_t layer1_actual[8][6] = {
-        {KC_TAB, KC_EXLM, KC_AT, KC_LPRN, KC_RPRN, KC_PIPE},
-        {KC_ESC, KC_HASH, KC_DLR, KC_LCBR, KC_RCBR, KC_GRV},
-        {KC_LCTL, KC_PERC, KC_CIRC, KC_LBRC, KC_RBRC, KC_TILD},
-        {KC_NO, KC_NO, KC_NO, KC_LALT, KC_TRNS, KC_SPC},
-        {KC_QUOT, KC_7, KC_8, KC_9, KC_ASTR, KC_GRV},
-        {KC_NO, KC_4, KC_5, KC_6, KC_EQL, KC_MINS},
-        {KC_AMPR, KC_1, KC_LABK, KC_RABK, KC_SLSH, KC_QUOT},
-        {KC_NO, KC_NO, KC_NO, KC_BSPC, MO(3), KC_BSPC}
-    };
-    if (row < 8 && col < 6) return layer1_actual[row][col];
-    return KC_NO;
-}
-
 typedef enum {
     // L1_CAT_NUMBER,
     L1_CAT_BRACKET,
@@ -488,21 +622,6 @@ layer1_category_t get_layer1_category(uint16_t keycode) {
     return L1_CAT_SYMBOL;
 }
 
-uint16_t get_layer2_keycode(uint8_t row, uint8_t col) {
-    const uint16_t layer2_actual[8][6] = {
-        {KC_ESC, KC_1, KC_2, KC_3, KC_4, KC_5},
-        {KC_LSFT, KC_NO, KC_F5, KC_F6, KC_F7, KC_F8},
-        {KC_LCTL, KC_NO, KC_F9, KC_F10, KC_F11, KC_F12},
-        {KC_NO, KC_NO, KC_NO, KC_LALT, MO(3), KC_SPC},
-        {KC_6, KC_7, KC_8, KC_9, KC_0, KC_PGUP},
-        {KC_LEFT, KC_DOWN, KC_UP, KC_RGHT, RGB_VAD, RGB_VAI},
-        {KC_HOME, KC_F1, KC_F2, KC_F3, KC_F4, KC_PGDN},
-        {KC_NO, KC_NO, KC_NO, KC_BSPC, KC_TRNS, KC_LSFT}
-    };
-    if (row < 8 && col < 6) return layer2_actual[row][col];
-    return KC_NO;
-}
-
 typedef enum {
     L2_CAT_NUMBER,
     L2_CAT_FUNCTION,
@@ -553,21 +672,6 @@ typedef enum {
     L3_CAT_OTHER
 } layer3_category_t;
 
-uint16_t get_layer3_keycode(uint8_t row, uint8_t col) {
-    const uint16_t layer3_actual[8][6] = {
-        {QK_BOOT, RGB_TOG_CUSTOM, GAMING_MODE, DEFAULT_MODE, XXXXXXX, XXXXXXX},
-        {XXXXXXX, RGB_HUI, RGB_SAI, RGB_VAI, XXXXXXX, XXXXXXX},
-        {XXXXXXX, RGB_HUD, RGB_SAD, RGB_VAD, XXXXXXX, XXXXXXX},
-        {XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX},
-        {XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX},
-        {XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX},
-        {XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX},
-        {XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX}
-    };
-    if (row < 8 && col < 6) return layer3_actual[row][col];
-    return KC_NO;
-}
-
 layer3_category_t get_layer3_category(uint16_t keycode) {
     // RGB controls
     if (keycode == RGB_TOG_CUSTOM) {
@@ -607,21 +711,6 @@ typedef enum {
     L4_CAT_OTHER
 } layer4_category_t;
 
-uint16_t get_layer4_keycode(uint8_t row, uint8_t col) {
-    const uint16_t layer4_actual[8][6] = {
-        {KC_TAB, KC_Q, KC_W, KC_E, KC_R, KC_T},
-        {KC_LSFT, KC_A, KC_S, KC_D, KC_F, KC_G},
-        {KC_LCTL, KC_Z, KC_X, KC_C, KC_V, KC_B},
-        {KC_LALT, MO(5), KC_SPC, KC_BSPC, MO(2), KC_LSFT},
-        {KC_Y, KC_U, KC_I, KC_O, KC_P, KC_DEL},
-        {KC_H, KC_J, KC_K, KC_L, KC_SCLN, KC_ENT},
-        {KC_N, KC_M, KC_COMM, KC_DOT, KC_SLSH, KC_QUOT},
-        {KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO}
-    };
-    if (row < 8 && col < 6) return layer4_actual[row][col];
-    return KC_NO;
-}
-
 layer4_category_t get_layer4_category(uint16_t keycode) {
     if (keycode == KC_TAB || keycode == KC_ENT || keycode == KC_SPC ||
         keycode == KC_BSPC || keycode == KC_LALT || keycode == KC_LSFT ||
@@ -632,281 +721,870 @@ layer4_category_t get_layer4_category(uint16_t keycode) {
     return L4_CAT_OTHER;
 }
 
-// // ============================================================================
-// // LAYER 5: GAMING LAYER 1 (NUMBERS & ARROWS)
-// // ============================================================================
-//
-// typedef enum {
-//     L5_CAT_NUMBER,
-//     L5_CAT_ARROW,
-//     L5_CAT_MOD,
-//     L5_CAT_OTHER
-// } layer5_category_t;
-//
-// uint16_t get_layer5_keycode(uint8_t row, uint8_t col) {
-//     const uint16_t layer5_actual[8][6] = {
-//         {KC_TAB, KC_1, KC_2, KC_3, KC_4, KC_5},
-//         {KC_ESC, KC_HASH, KC_DLR, KC_LCBR, KC_RCBR, KC_GRV},
-//         {KC_LCTL, KC_PERC, KC_CIRC, KC_LBRC, KC_RBRC, KC_TILD},
-//         {KC_LALT, _______, KC_SPC, KC_BSPC, MO(3), KC_0},
-//         {KC_6, KC_7, KC_8, KC_9, KC_0, KC_GRV},
-//         {XXXXXXX, KC_4, KC_UP, KC_6, KC_EQL, KC_MINS},
-//         {KC_AMPR, KC_LEFT, KC_DOWN, KC_RIGHT, KC_DOT, KC_QUOT},
-//         {KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO}
-//     };
-//     if (row < 8 && col < 6) return layer5_actual[row][col];
-//     return KC_NO;
-// }
-//
-// layer5_category_t get_layer5_category(uint16_t keycode) {
-//     // Mod keys
-//     if (keycode == KC_ESC || keycode == KC_LCTL || keycode == KC_LALT ||
-//         keycode == KC_SPC || keycode == KC_BSPC || keycode == KC_TRNS ||
-//         keycode == MO(3) || keycode == KC_NO) {
-//         return L5_CAT_MOD;
-//     }
-//
-//     // Numbers
-//     if (keycode >= KC_0 && keycode <= KC_9) {
-//         return L5_CAT_NUMBER;
-//     }
-//
-//     // Arrows
-//     if (keycode == KC_LEFT || keycode == KC_DOWN ||
-//         keycode == KC_UP || keycode == KC_RGHT) {
-//         return L5_CAT_ARROW;
-//     }
-//
-//     return L5_CAT_OTHER;
-// }
-
-// ============================================================================
-// RGB MATRIX INDICATOR CALLBACK
+// ============================================================================
+// LAYER 5: GAMING LAYER 1 (NUMBERS & ARROWS)
 // ============================================================================
 
-void keyboard_post_init_user(void) {
-    // Register the sync handler for split keyboard
-    transaction_register_rpc(USER_SYNC_RGB_ENABLED, user_sync_rgb_enabled_slave_handler);
+typedef enum {
+    L5_CAT_NUMBER,
+    L5_CAT_ARROW,
+    L5_CAT_MOD,
+    L5_CAT_OTHER
+} layer5_category_t;
+
+layer5_category_t get_layer5_category(uint16_t keycode) {
+    // Mod keys
+    if (keycode == KC_TAB || keycode == KC_ESC || keycode == KC_LCTL ||
+        keycode == KC_LALT || keycode == KC_SPC || keycode == KC_BSPC ||
+        keycode == KC_TRNS || keycode == MO(3)) {
+        return L5_CAT_MOD;
+    }
 
-    // Initialize RGB
-    rgb_matrix_enable_noeeprom();
-    rgb_matrix_mode_noeeprom(RGB_MATRIX_SOLID_REACTIVE_SIMPLE);
-    rgb_matrix_sethsv_noeeprom(L0_KEY_H, L0_KEY_S, L0_KEY_V);
-}
+    // Numbers
+    if (keycode >= KC_1 && keycode <= KC_0) {
+        return L5_CAT_NUMBER;
+    }
 
-// Sync custom data between split halves
-void housekeeping_task_user(void) {
-    if (is_keyboard_master()) {
-        // Send the current state to slave
-        transaction_rpc_send(USER_SYNC_RGB_ENABLED, sizeof(user_state), &user_state);
+    // Arrows
+    if (keycode == KC_LEFT || keycode == KC_DOWN ||
+        keycode == KC_UP || keycode == KC_RGHT) {
+        return L5_CAT_ARROW;
     }
+
+    return L5_CAT_OTHER;
 }
 
-layer_state_t layer_state_set_user(layer_state_t state) {
-    uint8_t layer = get_highest_layer(state);
+// ============================================================================
+// PER-KEY OVERLAY COLORS
+// ============================================================================
+
+// Resolves the overlay color and breathing channel of one key from its real
+// keycode in keymaps[]. Returns false for keys that show the layer's
+// background.
+static bool get_key_overlay(uint8_t layer, uint8_t row, uint8_t col, uint16_t keycode, HSV *hsv, uint8_t *channel) {
+    *channel = BREATH_NONE;
     switch (layer) {
         case 0:
-            rgb_matrix_mode_noeeprom(RGB_MATRIX_SOLID_REACTIVE_SIMPLE);
-            if (user_state.rgb_enabled) {
-                rgb_matrix_sethsv_noeeprom(L0_KEY_H, L0_KEY_S, L0_KEY_V);
-            } else {
-                rgb_matrix_sethsv_noeeprom(0, 0, 0);
-            }
-            break;
+            // Normal layer 0 (no breathing)
+            if (!is_layer0_mod(row, col)) return false;
+            *hsv = (HSV){L0_MOD_H, L0_MOD_S, L0_MOD_V};
+            return true;
+
         case 1:
-        case 5:
+            if (keycode == KC_NO) return false;
+            switch (get_layer1_category(keycode)) {
+                // case L1_CAT_NUMBER:
+                //     *hsv = (HSV){L1_NUMBERS_H, L1_NUMBERS_S, L1_NUMBERS_V};
+                //     *channel = BREATH_L1_NUMBERS;  // Numbers breathe
+                //     break;
+                case L1_CAT_BRACKET:
+                    *hsv = (HSV){L1_BRACKETS_H, L1_BRACKETS_S, L1_BRACKETS_V};
+                    *channel = BREATH_L1_BRACKETS;  // Brackets breathe
+                    break;
+                case L1_CAT_SYMBOL:
+                    *hsv = (HSV){L1_SYMBOLS_H, L1_SYMBOLS_S, L1_SYMBOLS_V};
+                    break;
+                case L1_CAT_MOD:
+                    *hsv = (HSV){L1_MOD_H, L1_MOD_S, L1_MOD_V};
+                    break;
+            }
+            return true;
+
         case 2:
+            if (keycode == KC_NO) return false;
+            switch (get_layer2_category(keycode)) {
+                case L2_CAT_NUMBER:
+                    *hsv = (HSV){L1_NUMBERS_H, L1_NUMBERS_S, L1_NUMBERS_V};
+                    *channel = BREATH_L2_NUMBERS;
+                    break;
+                case L2_CAT_FUNCTION:
+                    *hsv = (HSV){L2_FUNCTION_H, L2_FUNCTION_S, L2_FUNCTION_V};
+                    break;
+                case L2_CAT_ARROW:
+                    *hsv = (HSV){L2_ARROWS_H, L2_ARROWS_S, L2_ARROWS_V};
+                    *channel = BREATH_L2_ARROWS;  // Arrows breathe
+                    break;
+                case L2_CAT_MOD:
+                    *hsv = (HSV){L2_MOD_H, L2_MOD_S, L2_MOD_V};
+                    break;
+                case L2_CAT_OTHER:
+                    *hsv = (HSV){L2_OTHERS_H, L2_OTHERS_S, L2_OTHERS_V};
+                    break;
+            }
+            return true;
+
         case 3:
-            rgb_matrix_mode_noeeprom(RGB_MATRIX_BREATHING);
-            rgb_matrix_sethsv_noeeprom(0, 0, 0);
-            rgb_matrix_set_speed_noeeprom(BREATHING_SPEED);
-            break;
+#ifdef HEATMAP_ENABLE
+            // Heat of the typing layer from blue to red. The slave draws the
+            // levels the master synced when the layer came up.
+            {
+                uint8_t level = heatmap_level(HEATMAP_VIEW_LAYER, row, col);
+                *hsv = (HSV){HEATMAP_COLD_H - (uint16_t)level * HEATMAP_COLD_H / 255, 255, HEATMAP_V};
+                return true;
+            }
+#endif
+            if (keycode == KC_NO) return false;
+            switch (get_layer3_category(keycode)) {
+                case L3_CAT_SYSTEM:
+                    *hsv = (HSV){0, 255, 100}; // RED
+                    break;
+                case L3_CAT_GAMING:
+                    *hsv = (HSV){L0_MOD_H, L0_MOD_S, L0_MOD_V};
+                    *channel = BREATH_L3_MODES;
+                    break;
+                case L3_CAT_DEFAULT:
+                    *hsv = (HSV){L0_KEY_H, L0_KEY_S, L0_KEY_V};
+                    *channel = BREATH_L3_MODES;
+                    break;
+                case L3_CAT_RGB:
+                    *hsv = (HSV){144, 255, 100};
+                    break;
+                case L3_CAT_MOD:
+                    *hsv = (HSV){214, 255, 100};
+                    break;
+                case L3_CAT_OTHER:
+                    *hsv = (HSV){0, 0, 100};
+                    *channel = BREATH_L3_OTHERS;
+                    break;
+            }
+            return true;
+
         case 4:
-            rgb_matrix_mode_noeeprom(RGB_MATRIX_SOLID_REACTIVE_SIMPLE);
-            rgb_matrix_sethsv_noeeprom(L0_MOD_H, L0_MOD_S, L0_MOD_V);
-            break;
+            if (keycode == KC_NO) return false;
+            switch (get_layer4_category(keycode)) {
+                case L4_CAT_MOD:
+                    *hsv = (HSV){L0_KEY_H, L0_KEY_S, L0_KEY_V};
+                    break;
+                case L4_CAT_OTHER:
+                    *hsv = (HSV){L0_MOD_H, L0_MOD_S, L0_MOD_V};
+                    break;
+            }
+            return true;
+
+        // Gaming: static like layer 4, no breathing channels
+        case 5:
+            if (keycode == KC_NO) return false;
+            switch (get_layer5_category(keycode)) {
+                case L5_CAT_NUMBER:
+                    *hsv = (HSV){L1_NUMBERS_H, L1_NUMBERS_S, L1_NUMBERS_V};
+                    break;
+                case L5_CAT_ARROW:
+                    *hsv = (HSV){L2_ARROWS_H, L2_ARROWS_S, L2_ARROWS_V};
+                    break;
+                case L5_CAT_MOD:
+                    *hsv = (HSV){L0_KEY_H, L0_KEY_S, L0_KEY_V};
+                    break;
+                case L5_CAT_OTHER:
+                    *hsv = (HSV){L0_MOD_H, L0_MOD_S, L0_MOD_V};
+                    break;
+            }
+            return true;
     }
-    return state;
+    return false;
 }
 
-bool rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max) {
-    uint8_t layer = get_highest_layer(layer_state);
+// ============================================================================
+// LAYER FRAME CACHE
+// ============================================================================
+
+// The scheme for the active layer is resolved once into a packed RGB frame
+// and rebuilt only when the layer, rgb_enabled or the matrix HSV changes.
+// Keys without an overlay color show the matrix HSV as their background,
+// lit only by keypresses on reactive layers. Each half only resolves and
+// stores the LEDs it drives, so per-LED arrays hold one half and are
+// indexed with LED_LOCAL(). Only the active layer is cached: six full
+// frames would not fit next to the RGB matrix buffers on a Pro Micro.
+
+#define LED_MASK_BYTES ((RGB_MATRIX_LED_COUNT + 7) / 8)
+#define LED_LOCAL_COUNT_MAX (RGB_MATRIX_LED_COUNT / 2)  // Both halves of RGB_MATRIX_SPLIT
+#define LED_MASK_SET(mask, i) ((mask)[(i) >> 3] |= (uint8_t)(1 << ((i) & 7)))
+#define LED_MASK_CLEAR(mask, i) ((mask)[(i) >> 3] &= (uint8_t)~(1 << ((i) & 7)))
+#define LED_MASK_TEST(mask, i) ((mask)[(i) >> 3] & (uint8_t)(1 << ((i) & 7)))
+
+typedef struct {
+    bool    valid;
+    bool    rgb_enabled;
+    uint8_t layer;
+    HSV     base;                           // Matrix HSV the background was built from
+#ifdef HEATMAP_ENABLE
+    uint8_t heat_generation;                // heatmap_generation() the frame was built from
+#endif
+    RGB     color[LED_LOCAL_COUNT_MAX];     // Static color, at full level for breathing and reactive LEDs
+    uint8_t channel[LED_LOCAL_COUNT_MAX];   // Breathing channel of each breathing LED
+    uint8_t painted[LED_MASK_BYTES];        // LEDs the frame covers, every local LED
+    uint8_t breathing[LED_MASK_BYTES];      // LEDs that animate every frame
+    uint8_t reactive[LED_MASK_BYTES];       // Background keys lit by keypresses
+    uint8_t oneshot[LED_MASK_BYTES];        // LEDs showing a oneshot trigger
+    uint8_t oneshot_count;
+    struct {
+        uint8_t led;
+        uint8_t slot;
+    } oneshot_keys[8];                      // Oneshot trigger LEDs and their slot
+} layer_frame_t;
+
+static layer_frame_t layer_frame;
+
+// LEDs driven by this half under RGB_MATRIX_SPLIT
+static uint8_t local_led_min;
+static uint8_t local_led_max;
+
+// Index of a local LED in the arrays that only hold this half
+#define LED_LOCAL(led) ((led) - local_led_min)
+
+static void led_local_range_init(void) {
+    const uint8_t split[2] = RGB_MATRIX_SPLIT;
+    local_led_min = is_keyboard_left() ? 0 : split[0];
+    local_led_max = is_keyboard_left() ? split[0] : RGB_MATRIX_LED_COUNT;
+}
+
+static void layer_frame_paint(uint8_t led, HSV hsv, uint8_t channel) {
+    LED_MASK_SET(layer_frame.painted, led);
+    if (!layer_frame.rgb_enabled) return;  // Frame stays black
+    layer_frame.color[LED_LOCAL(led)] = hsv_to_rgb(hsv);
+    if (channel != BREATH_NONE) {
+        LED_MASK_SET(layer_frame.breathing, led);
+        layer_frame.channel[LED_LOCAL(led)] = channel;
+    }
+}
 
-    // Handle underglow
+static inline bool is_reactive_layer(uint8_t layer) {
+    return layer == 0;
+}
+
+static inline bool hsv_equal(HSV a, HSV b) {
+    return a.h == b.h && a.s == b.s && a.v == b.v;
+}
+
+// Drops the cached frame, so the next render rebuilds it from scratch with
+// no crossfade. The host benchmarks use it to time a rebuild on its own.
+void layer_frame_invalidate(void) {
+    layer_frame.valid = false;
+}
+
+static void layer_frame_build(uint8_t layer) {
+    memset(&layer_frame, 0, sizeof(layer_frame));
+    layer_frame.valid       = true;
+    layer_frame.layer       = layer;
+    layer_frame.rgb_enabled = user_state.rgb_enabled;
+    layer_frame.base        = rgb_matrix_get_hsv();
+#ifdef HEATMAP_ENABLE
+    layer_frame.heat_generation = heatmap_generation();
+#endif
+
+    // Only this half's LEDs, straight from the reverse map. The other half
+    // renders its own.
     HSV underglow_hsv = {UNDERGLOW_H, UNDERGLOW_S, UNDERGLOW_V};
-    RGB underglow_rgb = user_state.rgb_enabled ? hsv_to_rgb(underglow_hsv) : (RGB){0, 0, 0};
-    for (uint8_t i = UNDERGLOW_LEFT_START; i < UNDERGLOW_LEFT_END; i++) {
-        if (i >= led_min && i < led_max) {
-            rgb_matrix_set_color(i, underglow_rgb.r, underglow_rgb.g, underglow_rgb.b);
+    for (uint8_t led = local_led_min; led < local_led_max; led++) {
+        uint8_t key = pgm_read_byte(&led_to_key[led]);
+        if (key == LED_UNDERGLOW) {
+            layer_frame_paint(led, underglow_hsv, BREATH_NONE);
+            continue;
+        }
+
+        uint8_t  row     = LED_KEY_ROW(key);
+        uint8_t  col     = LED_KEY_COL(key);
+        uint16_t keycode = pgm_read_word(&keymaps[layer][row][col]);
+        HSV      hsv;
+        uint8_t  channel;
+        if (get_key_overlay(layer, row, col, keycode, &hsv, &channel)) {
+            layer_frame_paint(led, hsv, channel);
+        } else {
+            layer_frame_paint(led, layer_frame.base, BREATH_NONE);
+            if (is_reactive_layer(layer) && layer_frame.rgb_enabled) {
+                LED_MASK_SET(layer_frame.reactive, led);
+            }
+        }
+
+        // Oneshot triggers are tinted by their state on top of the overlay
+        uint8_t slot = get_oneshot_slot(keycode);
+        if (slot != 255 && layer_frame.oneshot_count < 8) {
+            LED_MASK_SET(layer_frame.painted, led);
+            LED_MASK_SET(layer_frame.oneshot, led);
+            layer_frame.oneshot_keys[layer_frame.oneshot_count].led  = led;
+            layer_frame.oneshot_keys[layer_frame.oneshot_count].slot = slot;
+            layer_frame.oneshot_count++;
         }
     }
-    for (uint8_t i = UNDERGLOW_RIGHT_START; i < UNDERGLOW_RIGHT_END; i++) {
-        if (i >= led_min && i < led_max) {
-            rgb_matrix_set_color(i, underglow_rgb.r, underglow_rgb.g, underglow_rgb.b);
+}
+
+// ============================================================================
+// INCREMENTAL RENDERER
+// ============================================================================
+
+// The last color computed for every LED, and which of them need recomputing.
+// An LED is only recomputed when one of its inputs changed: the frame
+// (everything), a oneshot state (its trigger LEDs), the breathing phase
+// (breathing LEDs) or a keypress fading out (its reactive LED). The matrix
+// buffer keeps its contents between frames, so only LEDs whose output
+// changed are written back. Static layers cost nothing after the first
+// frame.
+static RGB     led_out[LED_LOCAL_COUNT_MAX];  // By LED_LOCAL()
+static uint8_t led_dirty[LED_MASK_BYTES];
+static uint8_t led_push[LED_MASK_BYTES];      // Output differs from the matrix buffer
+static uint8_t reactive_lit[LED_MASK_BYTES];  // Reactive LEDs not yet back to black
+static uint8_t last_oneshot_packed;
+
+// ============================================================================
+// IDLE TIERS
+// ============================================================================
+
+// Both halves step down through the tiers on their own from
+// last_input_activity_elapsed() (SPLIT_ACTIVITY_ENABLE carries the master's
+// activity over to the slave), so waking needs no state from the other half.
+// Dimming lowers the overlay brightness and the breathing frame rate, the
+// off tier turns the matrix off and stops split sync traffic, and deep idle
+// slows the scan loop down. Input resets the timer and the next housekeeping
+// pass restores everything.
+
+#ifndef IDLE_DIM_MS
+#    define IDLE_DIM_MS 30000  // 30 seconds
+#endif
+#ifndef IDLE_OFF_MS
+#    define IDLE_OFF_MS 300000  // 5 minutes
+#endif
+#ifndef IDLE_DEEP_MS
+#    define IDLE_DEEP_MS 1800000  // 30 minutes
+#endif
+#ifndef IDLE_DIM_SCALE
+#    define IDLE_DIM_SCALE 96  // Overlay brightness while dimmed, of 256
+#endif
+#ifndef IDLE_DIM_BREATH_INTERVAL
+#    define IDLE_DIM_BREATH_INTERVAL 64  // Shortest gap between breathing steps while dimmed, ms
+#endif
+#ifndef IDLE_DEEP_SCAN_DELAY_MS
+#    define IDLE_DEEP_SCAN_DELAY_MS 8  // Added to every scan in deep idle
+#endif
+
+typedef enum {
+    IDLE_ACTIVE,
+    IDLE_DIM,
+    IDLE_OFF,
+    IDLE_DEEP
+} idle_tier_t;
+
+static idle_tier_t idle_tier = IDLE_ACTIVE;
+
+static idle_tier_t get_idle_tier(uint32_t idle_ms) {
+    if (idle_ms >= IDLE_DEEP_MS) return IDLE_DEEP;
+    if (idle_ms >= IDLE_OFF_MS) return IDLE_OFF;
+    if (idle_ms >= IDLE_DIM_MS) return IDLE_DIM;
+    return IDLE_ACTIVE;
+}
+
+static void idle_task(void) {
+    idle_tier_t tier = get_idle_tier(last_input_activity_elapsed());
+    if (tier == idle_tier) return;
+
+    // The matrix enable flag is synced from the master, so only it switches
+    if (is_keyboard_master()) {
+        if (tier >= IDLE_OFF && idle_tier < IDLE_OFF) {
+            rgb_matrix_disable_noeeprom();
+        } else if (tier < IDLE_OFF && idle_tier >= IDLE_OFF) {
+            rgb_matrix_enable_noeeprom();
         }
     }
+    idle_tier = tier;
+}
 
-    if (layer == 0) {
-        // Normal layer 0 (no breathing)
-        for (uint8_t row = 0; row < 8; row++) {
-            for (uint8_t col = 0; col < 6; col++) {
-                uint8_t led = get_led_from_matrix(row, col);
-                if (led == 255 || led >= led_max || led < led_min) continue;
-                if (is_layer0_mod(row, col)) {
-                    HSV hsv = {L0_MOD_H, L0_MOD_S, L0_MOD_V};
-                    RGB rgb = user_state.rgb_enabled ? hsv_to_rgb(hsv) : (RGB){0, 0, 0};
-                    rgb_matrix_set_color(led, rgb.r, rgb.g, rgb.b);
-                }
-            }
+// ============================================================================
+// POWER GOVERNOR
+// ============================================================================
+
+// Overlay colors bypass RGB_MATRIX_MAXIMUM_BRIGHTNESS, so the governor caps
+// what this half's overlay may draw. The scale is worked out once per frame
+// build, from the frame's peak per-channel sum: breathing and reactive LEDs
+// at full and oneshot triggers at their brightest tint. Static LEDs then
+// hold one color however the others move, and the scale only changes on a
+// rebuild, which recomputes every LED anyway. The comparison runs on
+// channel sums, so the only division happens when the frame is over budget.
+
+#ifndef RGB_GOVERNOR_MA_PER_CHANNEL
+#    define RGB_GOVERNOR_MA_PER_CHANNEL 20  // Draw of one channel at 255
+#endif
+
+#ifdef RGB_GOVERNOR_BUDGET_MA
+#    define RGB_GOVERNOR_BUDGET_SUM ((uint32_t)RGB_GOVERNOR_BUDGET_MA * 255 / RGB_GOVERNOR_MA_PER_CHANNEL)
+#else
+// What a stock effect may draw on one half: every channel at
+// RGB_MATRIX_MAXIMUM_BRIGHTNESS. The stock overlay stays within it, so only
+// colors raised past the keyboard's cap are scaled.
+#    define RGB_GOVERNOR_BUDGET_SUM ((uint32_t)RGB_MATRIX_LED_COUNT / 2 * 3 * RGB_MATRIX_MAXIMUM_BRIGHTNESS)
+#endif
+
+static struct {
+    uint16_t scale;  // 256 = full brightness
+} governor = {
+    .scale = 256,
+};
+
+static inline uint16_t rgb_sum(RGB rgb) {
+    return rgb.r + rgb.g + rgb.b;
+}
+
+// Call after a frame build
+static void governor_frame_update(void) {
+    RGB queued = hsv_to_rgb((HSV){OSM_QUEUED_H, OSM_QUEUED_S, OSM_QUEUED_V});
+    RGB active = hsv_to_rgb((HSV){OSM_ACTIVE_H, OSM_ACTIVE_S, OSM_ACTIVE_V});
+    uint16_t tint = rgb_sum(queued) > rgb_sum(active) ? rgb_sum(queued) : rgb_sum(active);
+
+    uint16_t peak = 0;
+    for (uint8_t i = local_led_min; i < local_led_max; i++) {
+        if (!LED_MASK_TEST(layer_frame.painted, i)) continue;
+        uint16_t sum = rgb_sum(layer_frame.color[LED_LOCAL(i)]);
+        if (LED_MASK_TEST(layer_frame.oneshot, i) && layer_frame.rgb_enabled && tint > sum) sum = tint;
+        peak += sum;
+    }
+    governor.scale = peak <= RGB_GOVERNOR_BUDGET_SUM ? 256 : (RGB_GOVERNOR_BUDGET_SUM << 8) / peak;
+}
+
+// Governor scale with the idle dimming folded in
+static uint16_t governor_output_scale(void) {
+    if (idle_tier >= IDLE_DIM) {
+        return (governor.scale * IDLE_DIM_SCALE) >> 8;
+    }
+    return governor.scale;
+}
+
+static inline uint8_t governor_apply(uint8_t value, uint16_t scale) {
+    return ((uint16_t)value * scale) >> 8;
+}
+
+static void led_dirty_merge(const uint8_t *mask) {
+    for (uint8_t i = 0; i < LED_MASK_BYTES; i++) {
+        led_dirty[i] |= mask[i];
+    }
+}
+
+static void led_push_all(void) {
+    memcpy(led_push, layer_frame.painted, sizeof(led_push));
+}
+
+// ============================================================================
+// RENDER SCHEDULER
+// ============================================================================
+
+// RGB_MATRIX_LED_PROCESS_LIMIT and RGB_MATRIX_LED_FLUSH_LIMIT are fixed at
+// compile time, so the scheduler bounds the overlay's own work instead. Each
+// chunk's recompute time is measured against a budget: going over halves the
+// number of dirty LEDs recomputed per chunk, leftover work with time to spare
+// grows it again. LEDs over the budget keep their last color for a tick. If
+// breathing LEDs are still waiting when the next breathing step comes due,
+// steps are spaced further apart, so heavy layers spread over more ticks and
+// static layers do no work at all.
+
+#ifndef RGB_RENDER_BUDGET_US
+#    define RGB_RENDER_BUDGET_US 100  // Overlay time allowed per render chunk
+#endif
+#ifndef RGB_BREATH_INTERVAL_MAX
+#    define RGB_BREATH_INTERVAL_MAX 32  // Longest gap between breathing steps, ms
+#endif
+
+#define RGB_RENDER_BUDGET_TICKS ((uint32_t)RGB_RENDER_BUDGET_US * PERF_CLOCK_HZ / 1000000)
+
+static struct {
+    uint8_t  led_budget;      // Dirty LEDs recomputed per chunk
+    uint8_t  breath_interval; // ms between breathing steps
+    uint16_t last_breath;
+} render_sched = {
+    .led_budget = RGB_MATRIX_LED_COUNT,
+};
+
+static bool led_breathing_backlog(void) {
+    for (uint8_t i = 0; i < LED_MASK_BYTES; i++) {
+        if (led_dirty[i] & layer_frame.breathing[i]) return true;
+    }
+    return false;
+}
+
+static bool render_sched_breathing_due(void) {
+    uint8_t interval = render_sched.breath_interval;
+    if (idle_tier >= IDLE_DIM && interval < IDLE_DIM_BREATH_INTERVAL) {
+        interval = IDLE_DIM_BREATH_INTERVAL;
+    }
+    if (timer_elapsed(render_sched.last_breath) < interval) {
+        return false;
+    }
+    render_sched.last_breath = timer_read();
+
+    if (led_breathing_backlog()) {
+        if (render_sched.breath_interval < RGB_BREATH_INTERVAL_MAX) {
+            render_sched.breath_interval += 2;
         }
+    } else if (render_sched.breath_interval > 0) {
+        render_sched.breath_interval--;
     }
-    else if (layer == 1) {
-        for (uint8_t row = 0; row < 8; row++) {
-            for (uint8_t col = 0; col < 6; col++) {
-                uint16_t keycode = get_layer1_keycode(row, col);
-                if (keycode == KC_NO) continue;
-                layer1_category_t cat = get_layer1_category(keycode);
-                uint8_t led = get_led_from_matrix(row, col);
-                if (led == 255 || led >= led_max || led < led_min) continue;
-                HSV hsv;
-                bool apply_breathing = false;
-                switch (cat) {
-                    // case L1_CAT_NUMBER:
-                    //     hsv = (HSV){L1_NUMBERS_H, L1_NUMBERS_S, L1_NUMBERS_V};
-                    //     apply_breathing = true;  // Numbers breathe
-                    //     break;
-                    case L1_CAT_BRACKET:
-                        hsv = (HSV){L1_BRACKETS_H, L1_BRACKETS_S, L1_BRACKETS_V};
-                        apply_breathing = true;  // Brackets breathe
-                        break;
-                    case L1_CAT_SYMBOL:
-                        hsv = (HSV){L1_SYMBOLS_H, L1_SYMBOLS_S, L1_SYMBOLS_V};
-                        break;
-                    case L1_CAT_MOD:
-                        hsv = (HSV){L1_MOD_H, L1_MOD_S, L1_MOD_V};
-                        break;
-                }
-                if (apply_breathing && user_state.rgb_enabled) {
-                    hsv.v = breathing_brightness(hsv.v, 0);
-                }
-                RGB rgb = user_state.rgb_enabled ? hsv_to_rgb(hsv) : (RGB){0, 0, 0};
-                rgb_matrix_set_color(led, rgb.r, rgb.g, rgb.b);
-            }
+    return breathing_update();
+}
+
+static void render_sched_adjust(uint32_t elapsed, bool backlog) {
+    uint32_t budget = RGB_RENDER_BUDGET_TICKS ? RGB_RENDER_BUDGET_TICKS : 1;
+    if (elapsed > budget) {
+        render_sched.led_budget = render_sched.led_budget > 2 ? render_sched.led_budget / 2 : 1;
+    } else if (backlog && elapsed < budget / 2 && render_sched.led_budget < RGB_MATRIX_LED_COUNT) {
+        render_sched.led_budget++;
+    }
+}
+
+// ============================================================================
+// LAYER CROSSFADE
+// ============================================================================
+
+// On a rebuild the colors on screen are snapshotted and every LED blends
+// from its snapshot to its new color over RGB_LAYER_FADE_MS. The 8-bit alpha
+// is worked out once per render chunk, so a blended LED costs two
+// multiplies per channel. A change during a fade snapshots the blended
+// colors, so flicking MO(1) or MO(2) never jumps. Only this half's LEDs are
+// kept.
+
+#ifndef RGB_LAYER_FADE_MS
+#    define RGB_LAYER_FADE_MS 150  // 0 switches instantly
+#endif
+
+static RGB      fade_from[LED_LOCAL_COUNT_MAX];
+static uint16_t fade_start;
+static bool     fading = false;
+
+// 0 shows fade_from, 256 shows the target
+static uint16_t fade_alpha(void) {
+    if (!fading) return 256;
+    uint16_t elapsed = timer_elapsed(fade_start);
+    if (elapsed >= RGB_LAYER_FADE_MS) {
+        fading = false;
+        return 256;
+    }
+    return ((uint32_t)elapsed << 8) / RGB_LAYER_FADE_MS;
+}
+
+static inline uint8_t fade_mix(uint8_t from, uint8_t to, uint16_t alpha) {
+    return ((uint16_t)from * (256 - alpha) + (uint16_t)to * alpha) >> 8;
+}
+
+static RGB fade_blend(uint8_t led, RGB to, uint16_t alpha) {
+    RGB from = fade_from[LED_LOCAL(led)];
+    return (RGB){fade_mix(from.r, to.r, alpha), fade_mix(from.g, to.g, alpha), fade_mix(from.b, to.b, alpha)};
+}
+
+// Call before the frame is rebuilt, while led_out still holds the old one
+static void fade_begin(void) {
+    if (RGB_LAYER_FADE_MS == 0 || !layer_frame.valid) return;
+    uint16_t alpha = fade_alpha();
+    for (uint8_t i = local_led_min; i < local_led_max; i++) {
+        RGB shown = {0, 0, 0};
+        if (LED_MASK_TEST(layer_frame.painted, i)) {
+            RGB out = led_out[LED_LOCAL(i)];
+            shown   = alpha < 256 ? fade_blend(i, out, alpha) : out;
         }
+        fade_from[LED_LOCAL(i)] = shown;
     }
-    else if (layer == 2) {
-        for (uint8_t row = 0; row < 8; row++) {
-            for (uint8_t col = 0; col < 6; col++) {
-                uint16_t keycode = get_layer2_keycode(row, col);
-                if (keycode == KC_NO) continue;
-                layer2_category_t cat = get_layer2_category(keycode);
-                uint8_t led = get_led_from_matrix(row, col);
-                if (led == 255 || led >= led_max || led < led_min) continue;
-                HSV hsv;
-                bool apply_breathing = false;
-                switch (cat) {
-                    case L2_CAT_NUMBER:
-                        hsv = (HSV){L1_NUMBERS_H, L1_NUMBERS_S, L1_NUMBERS_V};
-                        apply_breathing = true;
-                        break;
-                    case L2_CAT_FUNCTION:
-                        hsv = (HSV){L2_FUNCTION_H, L2_FUNCTION_S, L2_FUNCTION_V};
-                        break;
-                    case L2_CAT_ARROW:
-                        hsv = (HSV){L2_ARROWS_H, L2_ARROWS_S, L2_ARROWS_V};
-                        apply_breathing = true;  // Arrows breathe
-                        break;
-                    case L2_CAT_MOD:
-                        hsv = (HSV){L2_MOD_H, L2_MOD_S, L2_MOD_V};
-                        break;
-                    case L2_CAT_OTHER:
-                        hsv = (HSV){L2_OTHERS_H, L2_OTHERS_S, L2_OTHERS_V};
-                        break;
-                }
-                if (apply_breathing && user_state.rgb_enabled) {
-                    hsv.v = breathing_brightness(hsv.v, 0);
-                }
-                RGB rgb = user_state.rgb_enabled ? hsv_to_rgb(hsv) : (RGB){0, 0, 0};
-                rgb_matrix_set_color(led, rgb.r, rgb.g, rgb.b);
-            }
+    fade_start = timer_read();
+    fading = true;
+}
+
+static inline uint16_t reactive_offset(uint16_t tick) {
+    return scale16by8(tick, qadd8(rgb_matrix_get_speed(), 1));
+}
+
+// Same fade as SOLID_REACTIVE_SIMPLE, from the most recent hit on the LED
+static uint8_t reactive_level(uint8_t led) {
+    uint16_t tick = UINT16_MAX;
+    for (int8_t i = g_last_hit_tracker.count - 1; i >= 0; i--) {
+        if (g_last_hit_tracker.index[i] == led) {
+            tick = g_last_hit_tracker.tick[i];
+            break;
+        }
+    }
+    uint16_t offset = reactive_offset(tick);
+    return offset < 255 ? 255 - offset : 0;
+}
+
+static void led_render_update_inputs(void) {
+    uint8_t layer = get_highest_layer(layer_state);
+
+    // Rebuild the cached frame on a layer change (the slave only sees
+    // layer_state, never layer_state_set_user), an RGB toggle, a new
+    // background color or, on the heatmap layer, new synced levels
+    bool rebuild = !layer_frame.valid || layer_frame.layer != layer ||
+                   layer_frame.rgb_enabled != user_state.rgb_enabled ||
+                   !hsv_equal(layer_frame.base, rgb_matrix_get_hsv());
+#ifdef HEATMAP_ENABLE
+    rebuild = rebuild || (layer == 3 && layer_frame.heat_generation != heatmap_generation());
+#endif
+    if (rebuild) {
+        fade_begin();
+        layer_frame_build(layer);
+        governor_frame_update();
+        led_dirty_merge(layer_frame.painted);
+    }
+
+    uint8_t oneshot_packed = get_oneshot_packed();
+    if (oneshot_packed != last_oneshot_packed) {
+        last_oneshot_packed = oneshot_packed;
+        led_dirty_merge(layer_frame.oneshot);
+    }
+
+    if (render_sched_breathing_due()) {
+        led_dirty_merge(layer_frame.breathing);
+    }
+
+    // Reactive keys change from a new hit until they are back to black
+    led_dirty_merge(reactive_lit);
+    for (uint8_t i = 0; i < g_last_hit_tracker.count; i++) {
+        uint8_t led = g_last_hit_tracker.index[i];
+        if (LED_MASK_TEST(layer_frame.reactive, led) && reactive_offset(g_last_hit_tracker.tick[i]) < 255) {
+            LED_MASK_SET(led_dirty, led);
         }
     }
-    else if (layer == 3) {
-        for (uint8_t row = 0; row < 8; row++) {
-            for (uint8_t col = 0; col < 6; col++) {
-                uint16_t keycode = get_layer3_keycode(row, col);
-                if (keycode == KC_NO) continue;
-                layer3_category_t cat = get_layer3_category(keycode);
-                uint8_t led = get_led_from_matrix(row, col);
-                if (led == 255 || led >= led_max || led < led_min) continue;
-                HSV hsv;
-                bool apply_breathing = false;
-                switch (cat) {
-                    case L3_CAT_SYSTEM:
-                        hsv = (HSV){0, 255, 100}; // RED
-                        break;
-                    case L3_CAT_GAMING:
-                        hsv = (HSV){L0_MOD_H, L0_MOD_S, L0_MOD_V};
-                        apply_breathing = true;
-                        break;
-                    case L3_CAT_DEFAULT:
-                        hsv = (HSV){L0_KEY_H, L0_KEY_S, L0_KEY_V};
-                        apply_breathing = true;
-                        break;
-                    case L3_CAT_RGB:
-                        hsv = (HSV){144, 255, 100};
-                        break;
-                    case L3_CAT_MOD:
-                        hsv = (HSV){214, 255, 100};
-                        break;
-                    case L3_CAT_OTHER:
-                        hsv = (HSV){0, 0, 100};
-                        apply_breathing = true;
-                        break;
-                }
-                if (apply_breathing && user_state.rgb_enabled) {
-                    hsv.v = breathing_brightness(hsv.v, 0);
-                }
-                RGB rgb = user_state.rgb_enabled ? hsv_to_rgb(hsv) : (RGB){0, 0, 0};
-                rgb_matrix_set_color(led, rgb.r, rgb.g, rgb.b);
+}
+
+static RGB led_compute(uint8_t led) {
+    if (LED_MASK_TEST(layer_frame.oneshot, led) && layer_frame.rgb_enabled) {
+        for (uint8_t i = 0; i < layer_frame.oneshot_count; i++) {
+            if (layer_frame.oneshot_keys[i].led != led) continue;
+            switch (get_oneshot_state(layer_frame.oneshot_keys[i].slot)) {
+                case os_up_queued:
+                    return hsv_to_rgb((HSV){OSM_QUEUED_H, OSM_QUEUED_S, OSM_QUEUED_V});
+                case os_down_unused:
+                case os_down_used:
+                    return hsv_to_rgb((HSV){OSM_ACTIVE_H, OSM_ACTIVE_S, OSM_ACTIVE_V});
+                default:
+                    break;
             }
         }
     }
-    else if (layer == 4) {
-        for (uint8_t row = 0; row < 8; row++) {
-            for (uint8_t col = 0; col < 6; col++) {
-                uint16_t keycode = get_layer4_keycode(row, col);
-                if (keycode == KC_NO) continue;
-                layer4_category_t cat = get_layer4_category(keycode);
-                uint8_t led = get_led_from_matrix(row, col);
-                if (led == 255 || led >= led_max || led < led_min) continue;
-                HSV hsv;
-                bool apply_breathing = false;
-                switch (cat) {
-                    case L4_CAT_MOD:
-                        hsv = (HSV){L0_KEY_H, L0_KEY_S, L0_KEY_V};
-                        break;
-                    case L4_CAT_OTHER:
-                        hsv = (HSV){L0_MOD_H, L0_MOD_S, L0_MOD_V};
-                        break;
-                }
-                if (apply_breathing && user_state.rgb_enabled) {
-                    hsv.v = breathing_brightness(hsv.v, 0);
-                }
-                RGB rgb = user_state.rgb_enabled ? hsv_to_rgb(hsv) : (RGB){0, 0, 0};
-                rgb_matrix_set_color(led, rgb.r, rgb.g, rgb.b);
+
+    RGB     rgb   = layer_frame.color[LED_LOCAL(led)];
+    uint8_t level = 255;
+    if (LED_MASK_TEST(layer_frame.breathing, led)) {
+        level = breathing_level(layer_frame.channel[LED_LOCAL(led)]);
+    } else if (LED_MASK_TEST(layer_frame.reactive, led)) {
+        level = reactive_level(led);
+        if (level) {
+            LED_MASK_SET(reactive_lit, led);
+        } else {
+            LED_MASK_CLEAR(reactive_lit, led);
+        }
+    }
+    if (level < 255) {
+        rgb.r = breathing_scale(rgb.r, level);
+        rgb.g = breathing_scale(rgb.g, level);
+        rgb.b = breathing_scale(rgb.b, level);
+    }
+    return rgb;
+}
+
+// ============================================================================
+// RGB MODE CONTROLLER
+// ============================================================================
+
+// Keeps the mode, HSV and speed last applied to the matrix and only issues
+// the calls for what differs, since a mode call restarts the effect. A
+// request made within RGB_MODE_DEBOUNCE_MS of the previous one is held until
+// requests stop for that long, so a MO() roll only applies where it ends.
+
+#ifndef RGB_MODE_DEBOUNCE_MS
+#    define RGB_MODE_DEBOUNCE_MS 20
+#endif
+
+// Raw HID command for the controller's counters, next to the perf_stats ones
+//   USER_CMD_RGB_MODE_STATS -> mode calls issued, reinits avoided (u16 each)
+enum user_commands {
+    USER_CMD_RGB_MODE_STATS = 0x60,
+};
+
+typedef struct {
+    uint8_t mode;
+    HSV     hsv;
+    uint8_t speed;
+} rgb_mode_t;
+
+static struct {
+    rgb_mode_t applied;
+    rgb_mode_t pending;
+    bool       valid;        // Something has been applied
+    bool       has_pending;
+    uint16_t   last_request;
+    uint16_t   reinits;      // Mode calls issued
+    uint16_t   avoided;      // Requests that didn't need one, or were superseded
+} rgb_mode = {0};
+
+static void rgb_mode_apply(const rgb_mode_t *target) {
+    if (!rgb_mode.valid || target->mode != rgb_mode.applied.mode) {
+        rgb_matrix_mode_noeeprom(target->mode);
+        rgb_mode.reinits++;
+    } else {
+        rgb_mode.avoided++;
+    }
+    if (!rgb_mode.valid || !hsv_equal(target->hsv, rgb_mode.applied.hsv)) {
+        rgb_matrix_sethsv_noeeprom(target->hsv.h, target->hsv.s, target->hsv.v);
+    }
+    if (!rgb_mode.valid || target->speed != rgb_mode.applied.speed) {
+        rgb_matrix_set_speed_noeeprom(target->speed);
+    }
+    rgb_mode.applied = *target;
+    rgb_mode.valid   = true;
+}
+
+static void rgb_mode_request(uint8_t mode, HSV hsv, uint8_t speed) {
+    rgb_mode_t target  = {mode, hsv, speed};
+    bool       settled = timer_elapsed(rgb_mode.last_request) >= RGB_MODE_DEBOUNCE_MS;
+    rgb_mode.last_request = timer_read();
+
+    if (rgb_mode.has_pending) {
+        rgb_mode.has_pending = false;
+        rgb_mode.avoided++;
+    }
+    if (settled || !rgb_mode.valid) {
+        rgb_mode_apply(&target);
+    } else {
+        rgb_mode.pending     = target;
+        rgb_mode.has_pending = true;
+    }
+}
+
+// Call from housekeeping to apply a request once the layer has settled
+static void rgb_mode_task(void) {
+    if (!rgb_mode.has_pending || timer_elapsed(rgb_mode.last_request) < RGB_MODE_DEBOUNCE_MS) return;
+    rgb_mode.has_pending = false;
+    rgb_mode_apply(&rgb_mode.pending);
+}
+
+#ifdef RAW_ENABLE
+static bool rgb_mode_raw_hid(uint8_t *data, uint8_t length) {
+    if (data[0] != USER_CMD_RGB_MODE_STATS || length < 5) return false;
+    data[1] = rgb_mode.reinits & 0xFF;
+    data[2] = rgb_mode.reinits >> 8;
+    data[3] = rgb_mode.avoided & 0xFF;
+    data[4] = rgb_mode.avoided >> 8;
+    return true;
+}
+#endif
+
+// ============================================================================
+// RGB MATRIX CALLBACKS
+// ============================================================================
+
+void keyboard_post_init_user(void) {
+    // Register the sync handler for split keyboard
+    split_sync_init();
+    chord_init();
+
+#ifdef HEATMAP_ENABLE
+    heatmap_init();
+#endif
+
+    // Initialize RGB
+    rgb_matrix_enable_noeeprom();
+    rgb_mode_request(RGB_MATRIX_CUSTOM_LAYER_OVERLAY, (HSV){L0_KEY_H, L0_KEY_S, L0_KEY_V}, REACTIVE_SPEED);
+    // The first render builds the frame and marks every LED dirty
+    led_local_range_init();
+}
+
+// Sync custom data between split halves. Only sends when the state changes,
+// plus a low-rate heartbeat.
+void housekeeping_task_user(void) {
+    PERF_BEGIN(PERF_HOUSEKEEPING);
+    perf_stats_scan_tick();
+    macro_queue_task();
+    chord_task();
+    mouse_engine_task();
+#ifdef TAP_HOLD_ENABLE
+    tap_hold_task();
+#endif
+#ifdef HEATMAP_ENABLE
+    heatmap_task();
+#endif
+    rgb_mode_task();
+    idle_task();
+    // Nothing changes without input, so the slave's copy stays current
+    if (idle_tier < IDLE_OFF) {
+        split_sync_task(get_user_sync_state());
+    }
+    if (idle_tier == IDLE_DEEP) {
+        wait_ms(IDLE_DEEP_SCAN_DELAY_MS);
+    }
+    PERF_END(PERF_HOUSEKEEPING);
+}
+
+// The layer overlay is the only effect, so a layer change only sets the
+// background color it draws under the layer's scheme
+layer_state_t layer_state_set_user(layer_state_t state) {
+    PERF_BEGIN(PERF_LAYER_STATE_SET);
+#ifdef HEATMAP_ENABLE
+    // The slave has no counts of its own, so send it the levels to show
+    if (get_highest_layer(state) == 3 && get_highest_layer(layer_state) != 3) {
+        heatmap_sync(HEATMAP_VIEW_LAYER);
+    }
+#endif
+    HSV hsv = {0, 0, 0};
+    switch (get_highest_layer(state)) {
+        case 0:
+            if (user_state.rgb_enabled) {
+                hsv = (HSV){L0_KEY_H, L0_KEY_S, L0_KEY_V};
             }
+            break;
+        // Gaming layer: a static background, so nothing is recomputed per
+        // keypress or per breathing step
+        case 4:
+            hsv = (HSV){L0_MOD_H, L0_MOD_S, L0_MOD_V};
+            break;
+    }
+    rgb_mode_request(RGB_MATRIX_CUSTOM_LAYER_OVERLAY, hsv, REACTIVE_SPEED);
+    PERF_END(PERF_LAYER_STATE_SET);
+    return state;
+}
+
+// RGB_MATRIX_CUSTOM_LAYER_OVERLAY, see rgb_matrix_user.inc. Draws the whole
+// scheme in one pass, one render chunk at a time.
+bool layer_overlay_render(effect_params_t *params) {
+    RGB_MATRIX_USE_LIMITS(led_min, led_max);
+    PERF_BEGIN(PERF_RGB_INDICATORS);
+    led_render_update_inputs();
+
+    // Anything that changes every LED's output pushes all of them
+    static uint16_t pushed_scale = 256;
+    uint16_t scale = governor_output_scale();
+    if (params->init || scale != pushed_scale || fading) {
+        led_push_all();
+        pushed_scale = scale;
+    }
+    uint16_t alpha = fade_alpha();
+
+    // The frame only covers this half
+    if (led_min < local_led_min) led_min = local_led_min;
+    if (led_max > local_led_max) led_max = local_led_max;
+
+    // Only the recompute is timed: it is the part the LED budget controls.
+    // Frame rebuilds and pushes cost the same whatever the budget is.
+    uint32_t start  = PERF_CLOCK();
+    uint8_t  budget = render_sched.led_budget;
+    bool     backlog = false;
+    for (uint8_t i = led_min; i < led_max; i++) {
+        if (!LED_MASK_TEST(led_dirty, i)) continue;
+        if (!budget) {
+            backlog = true;
+            break;
         }
-        // uint8_t layer1_led = get_led_from_matrix(3, 4);
-        // uint8_t layer2_led = get_led_from_matrix(7, 4);
-        // if (layer1_led != 255) rgb_matrix_set_color(layer1_led, 0, 0, 0);
-        // if (layer2_led != 255) {
-        //     HSV hsv = {LAYER_IND_H, LAYER_IND_S, LAYER_IND_V};
-        //     RGB rgb = hsv_to_rgb(hsv);
-        //     rgb_matrix_set_color(layer2_led, rgb.r, rgb.g, rgb.b);
-        // }
+        led_out[LED_LOCAL(i)] = led_compute(i);
+        LED_MASK_CLEAR(led_dirty, i);
+        LED_MASK_SET(led_push, i);
+        budget--;
     }
-    return false;
+    render_sched_adjust(PERF_CLOCK() - start, backlog);
+
+    for (uint8_t i = led_min; i < led_max; i++) {
+        if (!LED_MASK_TEST(led_push, i)) continue;
+        LED_MASK_CLEAR(led_push, i);
+
+        RGB rgb = led_out[LED_LOCAL(i)];
+        if (alpha < 256) rgb = fade_blend(i, rgb, alpha);
+        if (scale < 256) {
+            rgb_matrix_set_color(i, governor_apply(rgb.r, scale), governor_apply(rgb.g, scale), governor_apply(rgb.b, scale));
+        } else {
+            rgb_matrix_set_color(i, rgb.r, rgb.g, rgb.b);
+        }
+    }
+    PERF_END(PERF_RGB_INDICATORS);
+    return rgb_matrix_check_finished_leds(led_max);
 }
 
 #endif // RGB_MATRIX_ENABLE
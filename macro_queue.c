@@ -0,0 +1,90 @@
+#include "macro_queue.h"
+#include "send_string.h"
+
+_Static_assert((MACRO_QUEUE_SIZE & (MACRO_QUEUE_SIZE - 1)) == 0, "MACRO_QUEUE_SIZE must be a power of two");
+
+typedef struct {
+    uint8_t keycode;
+    uint8_t mods;
+    uint8_t delay_ms;
+} macro_tap_t;
+
+static macro_tap_t queue[MACRO_QUEUE_SIZE];
+static uint8_t     head = 0;  // Next tap to send
+static uint8_t     tail = 0;  // Next free slot
+
+// The tap at head is either waiting to be pressed, held down, or already
+// released and waiting out its delay
+static enum {
+    tap_idle,
+    tap_down,
+    tap_delay,
+} phase = tap_idle;
+
+static uint16_t delay_start = 0;
+
+static inline uint8_t queue_used(void) {
+    return (uint8_t)(tail - head) & (MACRO_QUEUE_SIZE - 1);
+}
+
+// One slot stays empty to tell a full queue from an empty one
+static inline uint8_t queue_free(void) {
+    return MACRO_QUEUE_SIZE - 1 - queue_used();
+}
+
+bool macro_queue_tap(uint8_t keycode, uint8_t mods, uint8_t delay_ms) {
+    if (!queue_free()) return false;
+    queue[tail] = (macro_tap_t){keycode, mods, delay_ms};
+    tail = (tail + 1) & (MACRO_QUEUE_SIZE - 1);
+    return true;
+}
+
+bool macro_queue_string_P(const char *str, uint8_t delay_ms) {
+    uint8_t length = 0;
+    while (pgm_read_byte(str + length)) {
+        length++;
+    }
+    if (length > queue_free()) return false;
+
+    uint8_t mods = get_mods();
+    for (char c; (c = pgm_read_byte(str)); str++) {
+        uint8_t ascii = (uint8_t)c & 0x7F;
+        uint8_t keycode = pgm_read_byte(&ascii_to_keycode_lut[ascii]);
+        if (keycode == KC_NO) continue;
+        uint8_t shift = PGM_LOADBIT(ascii_to_shift_lut, ascii) ? MOD_BIT(KC_LSFT) : 0;
+        macro_queue_tap(keycode, mods | shift, delay_ms);
+    }
+    return true;
+}
+
+void macro_queue_task(void) {
+    switch (phase) {
+        case tap_idle:
+            if (head == tail) return;
+            add_weak_mods(queue[head].mods);
+            register_code(queue[head].keycode);
+            phase = tap_down;
+            return;
+
+        case tap_down:
+            // Key and mods go up in the same report
+            del_weak_mods(queue[head].mods);
+            unregister_code(queue[head].keycode);
+            if (queue[head].delay_ms) {
+                delay_start = timer_read();
+                phase = tap_delay;
+                return;
+            }
+            break;
+
+        case tap_delay:
+            if (timer_elapsed(delay_start) < queue[head].delay_ms) return;
+            break;
+    }
+    head = (head + 1) & (MACRO_QUEUE_SIZE - 1);
+    phase = tap_idle;
+}
+
+bool macro_queue_busy(void) {
+    return head != tail;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+// Non-blocking replacement for SEND_STRING. Taps are queued in a small ring
+// buffer and macro_queue_task() sends one report per call, so a macro never
+// stalls the scan loop. Each tap carries the mods that were active when it
+// was queued, applied as weak mods, so a queued oneshot applies to the whole
+// macro the same way it did with SEND_STRING, even though the oneshot is
+// released before the taps go out.
+
+#ifndef MACRO_QUEUE_SIZE
+#    define MACRO_QUEUE_SIZE 32  // Taps, power of two
+#endif
+
+// Queues a tap of a basic keycode with mods held around it, then waits
+// delay_ms before the next tap. Returns false if the queue is full.
+bool macro_queue_tap(uint8_t keycode, uint8_t mods, uint8_t delay_ms);
+
+// Queues a PROGMEM string with the current mods. The whole string is queued
+// or none of it is. Returns false if it doesn't fit.
+bool macro_queue_string_P(const char *str, uint8_t delay_ms);
+
+#define MACRO_QUEUE_STRING(string) macro_queue_string_P(PSTR(string), 0)
+
+// Call from housekeeping_task_user. Sends at most one report.
+void macro_queue_task(void);
+
+// Returns true while taps are waiting to be sent
+bool macro_queue_busy(void);
@@ -0,0 +1,173 @@
+#include "mouse_engine.h"
+
+_Static_assert(MOUSE_ENGINE_INTERVAL_MS >= 1 && MOUSE_ENGINE_INTERVAL_MS <= 64, "MOUSE_ENGINE_INTERVAL_MS must be 1-64");
+
+// Speeds in pixels or wheel detents per second: default, then KC_ACL0-2
+#ifndef MOUSE_ENGINE_CURSOR_SPEEDS
+#    define MOUSE_ENGINE_CURSOR_SPEEDS {900, 200, 600, 1800}
+#endif
+#ifndef MOUSE_ENGINE_WHEEL_SPEEDS
+#    define MOUSE_ENGINE_WHEEL_SPEEDS {12, 4, 10, 30}
+#endif
+
+// Share of the gap to the target speed closed per ms, out of 256
+#ifndef MOUSE_ENGINE_EASE
+#    define MOUSE_ENGINE_EASE 4
+#endif
+
+// Below this velocity (8.8, per step) a released axis stops
+#define STOP_VELOCITY 32
+
+#define EASE_PER_STEP (MOUSE_ENGINE_EASE * MOUSE_ENGINE_INTERVAL_MS > 256 ? 256 : MOUSE_ENGINE_EASE * MOUSE_ENGINE_INTERVAL_MS)
+
+// 181 / 256 ~ 1 / sqrt(2)
+#define DIAGONAL_SCALE 181
+
+enum {
+    DIR_UP    = 1 << 0,
+    DIR_DOWN  = 1 << 1,
+    DIR_LEFT  = 1 << 2,
+    DIR_RIGHT = 1 << 3,
+};
+
+// 32 bits so a high-resolution wheel's multiplied speeds fit
+typedef struct {
+    int32_t velocity;  // 8.8 per step
+    int32_t carry;     // 8.8 movement not reported yet
+} axis_t;
+
+static const uint16_t cursor_speeds[4] = MOUSE_ENGINE_CURSOR_SPEEDS;
+static const uint16_t wheel_speeds[4]  = MOUSE_ENGINE_WHEEL_SPEEDS;
+
+static uint8_t  cursor_dirs = 0;
+static uint8_t  wheel_dirs  = 0;
+static uint8_t  buttons     = 0;
+static uint8_t  sent_buttons = 0;
+static uint8_t  speed = 0;       // Index into the speed tables
+static uint8_t  speed_keys = 0;  // KC_ACL0-2 held, one bit each
+static axis_t   axes[4];         // x, y, h, v
+static uint16_t last_step = 0;
+
+// Target per step in 8.8 for a speed per second
+static inline int32_t step_speed(uint32_t per_second) {
+    return per_second * MOUSE_ENGINE_INTERVAL_MS * 256 / 1000;
+}
+
+static int8_t axis_step(axis_t *axis, int32_t target) {
+    int32_t gap  = target - axis->velocity;
+    int32_t ease = (gap * EASE_PER_STEP) >> 8;
+    // Close at least one unit, or slow targets would stall short of the gap
+    if (!ease && gap) ease = gap > 0 ? 1 : -1;
+    axis->velocity += ease;
+    if (!target && axis->velocity > -STOP_VELOCITY && axis->velocity < STOP_VELOCITY) {
+        axis->velocity = 0;
+        axis->carry    = 0;
+        return 0;
+    }
+
+    int32_t total = axis->carry + axis->velocity;
+    int32_t whole = total >> 8;  // Floors, so the carry stays in [0, 256)
+    axis->carry   = total - whole * 256;
+    if (whole > 127) whole = 127;
+    if (whole < -127) whole = -127;
+    return whole;
+}
+
+// Targets for one pair of axes from the held directions
+static void targets(uint8_t dirs, int32_t speed_step, int32_t *x, int32_t *y) {
+    *x = ((dirs & DIR_RIGHT) ? speed_step : 0) - ((dirs & DIR_LEFT) ? speed_step : 0);
+    *y = ((dirs & DIR_DOWN) ? speed_step : 0) - ((dirs & DIR_UP) ? speed_step : 0);
+    if (*x && *y) {
+        *x = (*x * DIAGONAL_SCALE) >> 8;
+        *y = (*y * DIAGONAL_SCALE) >> 8;
+    }
+}
+
+static void send(report_mouse_t *report) {
+    sent_buttons = report->buttons;
+    host_mouse_send(report);
+}
+
+static bool is_idle(void) {
+    for (uint8_t i = 0; i < 4; i++) {
+        if (axes[i].velocity) return false;
+    }
+    return !cursor_dirs && !wheel_dirs;
+}
+
+void mouse_engine_task(void) {
+    if (is_idle()) {
+        last_step = timer_read();
+        return;
+    }
+    if (timer_elapsed(last_step) < MOUSE_ENGINE_INTERVAL_MS) return;
+    last_step += MOUSE_ENGINE_INTERVAL_MS;
+    // A stalled loop drops the missed steps rather than bursting
+    if (timer_elapsed(last_step) >= MOUSE_ENGINE_INTERVAL_MS) last_step = timer_read();
+
+    int32_t x, y, h, v;
+    targets(cursor_dirs, step_speed(cursor_speeds[speed]), &x, &y);
+    targets(wheel_dirs, step_speed((uint32_t)wheel_speeds[speed] * MOUSE_ENGINE_WHEEL_MULTIPLIER), &h, &v);
+
+    report_mouse_t report = {0};
+    report.buttons = buttons;
+    report.x = axis_step(&axes[0], x);
+    report.y = axis_step(&axes[1], y);
+    report.h = axis_step(&axes[2], h);
+    report.v = -axis_step(&axes[3], v);  // Wheel up is positive
+
+    if (report.x || report.y || report.h || report.v || report.buttons != sent_buttons) {
+        send(&report);
+    }
+}
+
+bool process_mouse_engine(uint16_t keycode, keyrecord_t *record) {
+    uint8_t *dirs = &cursor_dirs;
+    uint8_t  bit  = 0;
+    switch (keycode) {
+        case KC_MS_U: bit = DIR_UP; break;
+        case KC_MS_D: bit = DIR_DOWN; break;
+        case KC_MS_L: bit = DIR_LEFT; break;
+        case KC_MS_R: bit = DIR_RIGHT; break;
+        case KC_WH_U: dirs = &wheel_dirs; bit = DIR_UP; break;
+        case KC_WH_D: dirs = &wheel_dirs; bit = DIR_DOWN; break;
+        case KC_WH_L: dirs = &wheel_dirs; bit = DIR_LEFT; break;
+        case KC_WH_R: dirs = &wheel_dirs; bit = DIR_RIGHT; break;
+
+        case KC_ACL0:
+        case KC_ACL1:
+        case KC_ACL2:
+            if (record->event.pressed) {
+                speed_keys |= 1 << (keycode - KC_ACL0);
+            } else {
+                speed_keys &= ~(1 << (keycode - KC_ACL0));
+            }
+            // The fastest speed key still held wins
+            speed = speed_keys & 4 ? 3 : speed_keys & 2 ? 2 : speed_keys & 1 ? 1 : 0;
+            return false;
+
+        case KC_BTN1 ... KC_BTN5: {
+            uint8_t mask = 1 << (keycode - KC_BTN1);
+            if (record->event.pressed) {
+                buttons |= mask;
+            } else {
+                buttons &= ~mask;
+            }
+            // Buttons go out at once instead of waiting for the next step
+            report_mouse_t report = {0};
+            report.buttons = buttons;
+            send(&report);
+            return false;
+        }
+
+        default:
+            return true;
+    }
+
+    if (record->event.pressed) {
+        *dirs |= bit;
+    } else {
+        *dirs &= ~bit;
+    }
+    return false;
+}
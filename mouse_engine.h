@@ -0,0 +1,41 @@
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+// Replacement for mousekeys. Cursor and wheel velocities are 8.8 fixed
+// point and ease towards the target speed every report interval, so motion
+// starts and stops smoothly instead of in steps. Fractional movement is
+// carried over between reports, diagonals are scaled by 1/sqrt(2), and a
+// report is only sent when something moved or a button changed. Every step
+// uses a fixed interval, so the same key timeline always produces the same
+// reports.
+//
+// KC_ACL0-2 pick slow, medium and fast speeds while held; with several held,
+// the fastest wins.
+//
+// With POINTING_DEVICE_HIRES_SCROLL_ENABLE the mouse report descriptor
+// declares QMK's resolution multiplier, and the wheel is reported in
+// fractions of a detent. The engine scales the wheel speeds to match, so the
+// page scrolls in small even steps instead of a whole detent at a time.
+
+#ifndef MOUSE_ENGINE_INTERVAL_MS
+#    define MOUSE_ENGINE_INTERVAL_MS 8  // Report interval, 1-64
+#endif
+
+// Wheel units per detent
+#ifndef MOUSE_ENGINE_WHEEL_MULTIPLIER
+#    if defined(POINTING_DEVICE_HIRES_SCROLL_ENABLE) && defined(POINTING_DEVICE_HIRES_SCROLL_MULTIPLIER)
+#        define MOUSE_ENGINE_WHEEL_MULTIPLIER POINTING_DEVICE_HIRES_SCROLL_MULTIPLIER
+#    elif defined(POINTING_DEVICE_HIRES_SCROLL_ENABLE)
+#        define MOUSE_ENGINE_WHEEL_MULTIPLIER 120  // QMK's default multiplier
+#    else
+#        define MOUSE_ENGINE_WHEEL_MULTIPLIER 1
+#    endif
+#endif
+
+// Handles the mouse keycodes. Returns false if the event was consumed. Call
+// from process_record_user.
+bool process_mouse_engine(uint16_t keycode, keyrecord_t *record);
+
+// Steps the motion model. Call from housekeeping_task_user.
+void mouse_engine_task(void);
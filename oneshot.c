@@ -1,57 +1,98 @@
 #include "oneshot.h"
+#include "report_batch.h"
 
-void update_oneshot(
-    oneshot_state *state,
-    uint16_t mod,
-    uint16_t trigger,
-    uint16_t keycode,
-    keyrecord_t *record
-) {
-    if (keycode == trigger) {
+// Oneshot state as mod bitmasks. A mod is in at most one of them; a mod in
+// none of them is up and unqueued.
+static uint8_t queued = 0;
+static uint8_t down_unused = 0;
+static uint8_t down_used = 0;
+
+static uint8_t get_trigger_mod(uint16_t keycode) {
+    for (uint8_t i = 0; i < oneshot_mod_count; i++) {
+        if (pgm_read_word(&oneshot_mods[i].trigger) == keycode) {
+            return pgm_read_byte(&oneshot_mods[i].mod);
+        }
+    }
+    return 0;
+}
+
+void update_oneshot_mods(uint16_t keycode, keyrecord_t *record) {
+    uint8_t add = 0;
+    uint8_t del = 0;
+    uint8_t mod = get_trigger_mod(keycode);
+
+    if (mod) {
         if (record->event.pressed) {
             // Trigger keydown
-            if (*state == os_up_unqueued) {
-                register_code(mod);
+            if (!((queued | down_unused | down_used) & mod)) {
+                add = mod;
             }
-            *state = os_down_unused;
+            queued &= ~mod;
+            down_used &= ~mod;
+            down_unused |= mod;
         } else {
             // Trigger keyup
-            switch (*state) {
-            case os_down_unused:
+            if (down_unused & mod) {
                 // If we didn't use the mod while trigger was held, queue it.
-                *state = os_up_queued;
-                break;
-            case os_down_used:
+                down_unused &= ~mod;
+                queued |= mod;
+            } else if (down_used & mod) {
                 // If we did use the mod while trigger was held, unregister it.
-                *state = os_up_unqueued;
-                unregister_code(mod);
-                break;
-            default:
-                break;
+                down_used &= ~mod;
+                del = mod;
             }
         }
     } else {
         if (record->event.pressed) {
-            if (is_oneshot_cancel_key(keycode) && *state != os_up_unqueued) {
+            if (is_oneshot_cancel_key(keycode)) {
                 // Cancel oneshot on designated cancel keydown.
-                *state = os_up_unqueued;
-                unregister_code(mod);
+                del = queued | down_unused | down_used;
+                queued = down_unused = down_used = 0;
             }
         } else {
             if (!is_oneshot_ignored_key(keycode)) {
                 // On non-ignored keyup, consider the oneshot used.
-                switch (*state) {
-                case os_down_unused:
-                    *state = os_down_used;
-                    break;
-                case os_up_queued:
-                    *state = os_up_unqueued;
-                    unregister_code(mod);
-                    break;
-                default:
-                    break;
-                }
+                del = queued;
+                queued = 0;
+                down_used |= down_unused;
+                down_unused = 0;
             }
         }
     }
+
+    if (add) add_mods(add);
+    if (del) del_mods(del);
+    if (add | del) report_batch_mods();
+}
+
+oneshot_state get_oneshot_state(uint8_t index) {
+    uint8_t mod = pgm_read_byte(&oneshot_mods[index].mod);
+    if (queued & mod) return os_up_queued;
+    if (down_unused & mod) return os_down_unused;
+    if (down_used & mod) return os_down_used;
+    return os_up_unqueued;
+}
+
+void set_oneshot_state(uint8_t index, oneshot_state state) {
+    uint8_t mod = pgm_read_byte(&oneshot_mods[index].mod);
+    queued &= ~mod;
+    down_unused &= ~mod;
+    down_used &= ~mod;
+    switch (state) {
+    case os_up_queued:
+        queued |= mod;
+        break;
+    case os_down_unused:
+        down_unused |= mod;
+        break;
+    case os_down_used:
+        down_used |= mod;
+        break;
+    default:
+        break;
+    }
+}
+
+bool is_oneshot_engaged(void) {
+    return (queued | down_unused | down_used) != 0;
 }
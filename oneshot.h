@@ -10,16 +10,36 @@ typedef enum {
     os_down_used,
 } oneshot_state;
 
+// A oneshot trigger keycode and the modifier it drives, as a MOD_BIT()
+typedef struct {
+    uint16_t trigger;
+    uint8_t mod;
+} oneshot_mod;
+
 // Custom oneshot mod implementation that doesn't rely on timers. If a mod is
 // used while it is held it will be unregistered on keyup as normal, otherwise
 // it will be queued and only released after the next non-mod keyup.
-void update_oneshot(
-    oneshot_state *state,
-    uint16_t mod,
-    uint16_t trigger,
-    uint16_t keycode,
-    keyrecord_t *record
-);
+//
+// Every entry of the oneshot_mods table is resolved in the same pass. The
+// state of all of them lives in three mod bitmasks (queued, down-unused and
+// down-used), and whatever mods an event adds or removes are batched with
+// report_batch_mods(), so they go out in the same report as the event's key.
+void update_oneshot_mods(uint16_t keycode, keyrecord_t *record);
+
+// State of the oneshot_mods entry at index
+oneshot_state get_oneshot_state(uint8_t index);
+
+// Overwrites the state of the oneshot_mods entry at index without touching
+// the registered mods. For mirroring the master's state on the slave.
+void set_oneshot_state(uint8_t index, oneshot_state state);
+
+// Returns true if any oneshot mod is held or queued
+bool is_oneshot_engaged(void);
+
+// To be implemented by the consumer. The oneshot table, in PROGMEM, and the
+// number of entries in it. Each entry must drive a different modifier.
+extern const oneshot_mod oneshot_mods[];
+extern const uint8_t oneshot_mod_count;
 
 // To be implemented by the consumer. Defines keys to cancel oneshot mods.
 bool is_oneshot_cancel_key(uint16_t keycode);
@@ -0,0 +1,87 @@
+#include "per_key_debounce.h"
+#include "debounce.h"
+#include <string.h>
+
+#ifndef DEBOUNCE
+#    define DEBOUNCE 5
+#endif
+
+_Static_assert(DEBOUNCE > 0 && DEBOUNCE <= 127, "DEBOUNCE must be 1-127 for per-key debounce");
+
+#define KEY_LOCKED 0x80  // Eager press lock, otherwise a pending change
+#define KEY_COUNT 0x7F   // ms left
+
+static uint8_t       keys[MATRIX_ROWS][MATRIX_COLS];
+static bool          counting   = false;
+static uint16_t      last_time  = 0;
+static layer_state_t mode_state = 0;
+static debounce_mode mode       = debounce_symmetric;
+
+void debounce_init(uint8_t num_rows) {
+    memset(keys, 0, sizeof(keys));
+    counting   = false;
+    last_time  = timer_read();
+    mode_state = layer_state | default_layer_state;
+    mode       = debounce_mode_for_layer(get_highest_layer(mode_state));
+}
+
+void debounce_free(void) {}
+
+static void update_mode(void) {
+    layer_state_t state = layer_state | default_layer_state;
+    if (state != mode_state) {
+        mode_state = state;
+        mode       = debounce_mode_for_layer(get_highest_layer(state));
+    }
+}
+
+bool debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed) {
+    uint16_t elapsed = timer_elapsed(last_time);
+    last_time += elapsed;
+    if (!changed && !counting) return false;
+    if (elapsed > KEY_COUNT) elapsed = KEY_COUNT;
+
+    update_mode();
+
+    bool cooked_changed = false;
+    counting            = false;
+    for (uint8_t row = 0; row < num_rows; row++) {
+        matrix_row_t diff = raw[row] ^ cooked[row];
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            uint8_t     *key = &keys[row][col];
+            matrix_row_t bit = (matrix_row_t)1 << col;
+
+            if (*key) {
+                uint8_t count = *key & KEY_COUNT;
+                if (count > elapsed) {
+                    if (!(*key & KEY_LOCKED) && !(diff & bit)) {
+                        *key = 0;  // Bounced back before it held
+                    } else {
+                        *key     = (*key & KEY_LOCKED) | (count - elapsed);
+                        counting = true;
+                    }
+                    continue;
+                }
+                bool pending = !(*key & KEY_LOCKED);
+                *key         = 0;
+                if (pending && (diff & bit)) {
+                    cooked[row] ^= bit;
+                    cooked_changed = true;
+                    continue;
+                }
+                // A lock ran out: a release during it starts below
+            }
+
+            if (!(diff & bit)) continue;
+            if (mode == debounce_eager && (raw[row] & bit)) {
+                cooked[row] |= bit;
+                cooked_changed = true;
+                *key           = KEY_LOCKED | DEBOUNCE;
+            } else {
+                *key = DEBOUNCE;
+            }
+            counting = true;
+        }
+    }
+    return cooked_changed;
+}
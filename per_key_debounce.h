@@ -0,0 +1,22 @@
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+// How a key's raw state becomes its debounced state
+typedef enum {
+    debounce_symmetric,  // Presses and releases both wait to be stable
+    debounce_eager,      // Presses go through at once, releases wait
+} debounce_mode;
+
+// Per-key debounce, built with DEBOUNCE_TYPE = custom. Each key keeps one
+// byte: a DEBOUNCE ms countdown and whether it is a lock after an eager
+// press or a change waiting to be confirmed. A pending change is dropped
+// if the key bounces back, and committed once it has held for DEBOUNCE ms.
+// An eager press is reported on the first scan that sees it and then locks
+// the key for DEBOUNCE ms, which filters the bounce that follows.
+//
+// The mode follows the highest active layer. The slave reads the master's
+// layers through SPLIT_LAYER_STATE_ENABLE.
+
+// To be implemented by the consumer. The debounce mode for a layer.
+debounce_mode debounce_mode_for_layer(uint8_t layer);
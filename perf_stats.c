@@ -0,0 +1,82 @@
+#include "perf_stats.h"
+#include <string.h>
+
+static perf_stat_t stats[PERF_SECTION_COUNT];
+static uint32_t    counters[PERF_COUNTER_COUNT];
+static uint16_t    scans = 0;
+static uint16_t    scan_rate = 0;
+static uint16_t    scan_window = 0;
+
+void perf_stats_record(uint8_t section, uint32_t elapsed) {
+    perf_stat_t *stat = &stats[section];
+    if (stat->count == 0 || elapsed < stat->min) stat->min = elapsed;
+    if (elapsed > stat->max) stat->max = elapsed;
+    stat->total += elapsed;
+    stat->count++;
+}
+
+void perf_stats_count(uint8_t counter) {
+    counters[counter]++;
+}
+
+void perf_stats_scan_tick(void) {
+    scans++;
+    if (timer_elapsed(scan_window) >= 1000) {
+        scan_window += 1000;
+        scan_rate = scans;
+        scans = 0;
+    }
+}
+
+const perf_stat_t *perf_stats_get(uint8_t section) {
+    return &stats[section];
+}
+
+uint16_t perf_stats_scan_rate(void) {
+    return scan_rate;
+}
+
+void perf_stats_reset(void) {
+    memset(stats, 0, sizeof(stats));
+    memset(counters, 0, sizeof(counters));
+}
+
+static uint8_t *put_u32(uint8_t *out, uint32_t value) {
+    for (uint8_t i = 0; i < 4; i++) {
+        *out++ = value >> (i * 8);
+    }
+    return out;
+}
+
+bool perf_stats_raw_hid(uint8_t *data, uint8_t length) {
+    switch (data[0]) {
+    case PERF_CMD_READ: {
+        if (length < 22 || data[1] >= PERF_SECTION_COUNT) return false;
+        const perf_stat_t *stat = &stats[data[1]];
+        uint8_t *out = &data[2];
+        out = put_u32(out, stat->count);
+        out = put_u32(out, stat->total);
+        out = put_u32(out, stat->min);
+        out = put_u32(out, stat->max);
+        put_u32(out, PERF_CLOCK_HZ);
+        return true;
+    }
+    case PERF_CMD_SCAN_RATE:
+        data[1] = scan_rate & 0xFF;
+        data[2] = scan_rate >> 8;
+        return true;
+    case PERF_CMD_RESET:
+        perf_stats_reset();
+        return true;
+    case PERF_CMD_COUNTERS: {
+        if (length < 1 + 4 * PERF_COUNTER_COUNT) return false;
+        uint8_t *out = &data[1];
+        for (uint8_t i = 0; i < PERF_COUNTER_COUNT; i++) {
+            out = put_u32(out, counters[i]);
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+// Free-running clock used to time callbacks. Override PERF_CLOCK() and
+// PERF_CLOCK_HZ in config.h (or on the host) to use another source.
+#ifndef PERF_CLOCK
+#    if defined(PROTOCOL_CHIBIOS)
+// System tick, 1 MHz on the RP2040
+#        define PERF_CLOCK() ((uint32_t)chVTGetSystemTimeX())
+#        define PERF_CLOCK_HZ CH_CFG_ST_FREQUENCY
+#    elif defined(__AVR__)
+#        include "timer_avr.h"
+// Millisecond counter extended with the raw Timer0 count, 4 us at 16 MHz.
+// The compare interrupt can bump the count between the two reads, pairing
+// the old millisecond with a wrapped raw count, so read again until the
+// millisecond is the same on both sides of the raw read.
+static inline uint32_t perf_clock_avr(void) {
+    uint32_t ms;
+    uint8_t  raw;
+    do {
+        ms  = timer_read32();
+        raw = TIMER_RAW;
+    } while (timer_read32() != ms);
+    return ms * (uint32_t)TIMER_RAW_TOP + raw;
+}
+#        define PERF_CLOCK() perf_clock_avr()
+#        define PERF_CLOCK_HZ TIMER_RAW_FREQ
+#    else
+#        define PERF_CLOCK() timer_read32()
+#        define PERF_CLOCK_HZ 1000
+#    endif
+#endif
+
+// Callbacks timed by the instrumentation layer
+enum perf_sections {
+    PERF_PROCESS_RECORD,
+    PERF_RGB_INDICATORS,
+    PERF_LAYER_STATE_SET,
+    PERF_HOUSEKEEPING,
+    PERF_HEATMAP,
+    PERF_SECTION_COUNT
+};
+
+typedef struct {
+    uint32_t count;
+    uint32_t total;  // PERF_CLOCK ticks
+    uint32_t min;
+    uint32_t max;
+} perf_stat_t;
+
+// Event counters
+enum perf_counters {
+    PERF_COUNT_KEY_EVENTS,  // Events through process_record_user
+    PERF_COUNT_FLUSHES,     // Batched mod changes sent in a report of their own
+    PERF_COUNT_COALESCED,   // Batched mod changes carried by the key's report
+    PERF_COUNTER_COUNT
+};
+
+// Raw HID commands. Requests and replies are RAW_EPSIZE bytes, replies echo
+// the command byte; multi-byte fields are little endian.
+//   PERF_CMD_READ, section -> count, total, min, max (u32 each), clock hz (u32)
+//   PERF_CMD_SCAN_RATE     -> scans in the last second (u16)
+//   PERF_CMD_RESET         -> clears every section and counter
+//   PERF_CMD_COUNTERS      -> every counter (u32 each), in perf_counters order
+enum perf_commands {
+    PERF_CMD_READ = 0x70,
+    PERF_CMD_SCAN_RATE,
+    PERF_CMD_RESET,
+    PERF_CMD_COUNTERS,
+};
+
+#ifdef PERF_STATS_ENABLE
+
+// Brackets a timed section. Both must be in the same scope.
+#    define PERF_BEGIN(section) uint32_t perf_start_##section = PERF_CLOCK()
+#    define PERF_END(section) perf_stats_record(section, PERF_CLOCK() - perf_start_##section)
+
+void perf_stats_record(uint8_t section, uint32_t elapsed);
+
+#    define PERF_COUNT(counter) perf_stats_count(counter)
+
+void perf_stats_count(uint8_t counter);
+
+// Call once per main loop pass to measure the matrix scan rate
+void perf_stats_scan_tick(void);
+
+const perf_stat_t *perf_stats_get(uint8_t section);
+uint16_t perf_stats_scan_rate(void);
+void perf_stats_reset(void);
+
+// Handles a raw HID request in place. Returns false for unknown commands.
+bool perf_stats_raw_hid(uint8_t *data, uint8_t length);
+
+#else
+
+#    define PERF_BEGIN(section)
+#    define PERF_END(section)
+#    define PERF_COUNT(counter)
+#    define perf_stats_scan_tick()
+
+#endif
@@ -0,0 +1,21 @@
+#include "report_batch.h"
+#include "perf_stats.h"
+
+static bool stale = false;
+
+void report_batch_mods(void) {
+    stale = true;
+}
+
+void report_batch_flush(void) {
+    if (!stale) return;
+    stale = false;
+
+    if (keyboard_report->mods == (get_mods() | get_weak_mods())) {
+        // A key action already sent them
+        PERF_COUNT(PERF_COUNT_COALESCED);
+        return;
+    }
+    PERF_COUNT(PERF_COUNT_FLUSHES);
+    send_keyboard_report();
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+// Keyboard report batching for one key event. Code that changes mods while
+// an event is processed marks the report stale with report_batch_mods()
+// instead of sending it. The event's own key action then sends one report
+// that carries the mods along with the key. report_batch_flush() sends the
+// report only if nothing else did, for events that end without a key action.
+//
+// QMK skips reports identical to the last one sent, so a flush after a key
+// action that already carried the mods costs nothing on the wire.
+
+// Marks the mods as changed without sending a report
+void report_batch_mods(void);
+
+// Sends the report if mods were changed and are not in it yet. Call at the
+// end of every event: from process_record_user when it returns false, and
+// from post_process_record_user.
+void report_batch_flush(void);
@@ -6,9 +6,11 @@ LTO_ENABLE          = yes
 RGBLIGHT_ENABLE     = no
 RGB_MATRIX_ENABLE   = yes # Can't have RGBLIGHT and RGB_MATRIX at the same time.
 RGB_MATRIX_DRIVER = ws2812
+RGB_MATRIX_CUSTOM_USER = yes
 VIALRGB_ENABLE = no
 CONSOLE_ENABLE = no
-MOUSEKEY_ENABLE     = yes
+MOUSEKEY_ENABLE     = no  # Replaced by mouse_engine.c
+MOUSE_ENABLE        = yes
 OLED_ENABLE         = no
 OLED_DRIVER         = SSD1306
 EXTRAKEY_ENABLE     = no
@@ -22,3 +24,37 @@ REPEAT_KEY_ENABLE = no
 SPACE_CADET_ENABLE = no
 GRAVE_ESC_ENABLE = no
 MAGIC_ENABLE = no
+
+DEBOUNCE_TYPE = custom  # per_key_debounce.c
+
+SRC += oneshot.c
+SRC += breathing.c
+SRC += split_sync.c
+SRC += macro_queue.c
+SRC += chord.c
+SRC += mouse_engine.c
+SRC += per_key_debounce.c
+SRC += report_batch.c
+
+# Opt-in callback timing, read back over raw HID. Compiled out otherwise.
+PERF_STATS_ENABLE ?= no
+ifeq ($(strip $(PERF_STATS_ENABLE)), yes)
+    RAW_ENABLE = yes
+    OPT_DEFS += -DPERF_STATS_ENABLE
+    SRC += perf_stats.c
+endif
+
+# Opt-in tap-hold resolver; makes layer 0 Escape a Shift on hold
+TAP_HOLD_ENABLE ?= no
+ifeq ($(strip $(TAP_HOLD_ENABLE)), yes)
+    OPT_DEFS += -DTAP_HOLD_ENABLE
+    SRC += tap_hold.c
+endif
+
+# Opt-in per-key usage heatmap, persisted to EEPROM and read over raw HID
+HEATMAP_ENABLE ?= no
+ifeq ($(strip $(HEATMAP_ENABLE)), yes)
+    RAW_ENABLE = yes
+    OPT_DEFS += -DHEATMAP_ENABLE
+    SRC += heatmap.c
+endif
@@ -0,0 +1,97 @@
+#include "split_sync.h"
+#include "transactions.h"
+
+#ifndef SPLIT_SYNC_HEARTBEAT_MS
+#    define SPLIT_SYNC_HEARTBEAT_MS 1000
+#endif
+
+#ifndef SPLIT_SYNC_RETRY_MS
+#    define SPLIT_SYNC_RETRY_MS 10
+#endif
+
+typedef struct __attribute__((packed)) {
+    uint8_t  version;
+    uint16_t state;
+} split_sync_payload_t;
+
+// Master side
+static split_sync_payload_t current = {0};
+static bool                 in_sync = false;
+static bool                 retrying = false;
+static uint16_t             last_send = 0;
+
+// Slave side
+static bool     received = false;
+static uint8_t  applied_version = 0;
+static uint16_t applied_state = 0;
+
+// Counters
+static split_sync_stats_t counting = {0};
+static split_sync_stats_t stats = {0};
+static uint16_t           stats_window = 0;
+
+static void split_sync_slave_handler(uint8_t in_buflen, const void *in_data, uint8_t out_buflen, void *out_data) {
+    if (in_buflen < sizeof(split_sync_payload_t)) return;
+    const split_sync_payload_t *m2s = (const split_sync_payload_t *)in_data;
+
+    // Heartbeats and retries repeat what was applied. Anything else is
+    // applied, newer or not: a master that reset counts again from 0.
+    if (received && m2s->version == applied_version && m2s->state == applied_state) return;
+    received = true;
+    applied_version = m2s->version;
+    applied_state = m2s->state;
+    split_sync_apply(m2s->state);
+}
+
+void split_sync_init(void) {
+    transaction_register_rpc(USER_SYNC_STATE, split_sync_slave_handler);
+    stats_window = timer_read();
+}
+
+void split_sync_task(uint16_t state) {
+    if (!is_keyboard_master()) return;
+
+    counting.passes++;
+    if (timer_elapsed(stats_window) >= 1000) {
+        stats_window += 1000;
+        stats = counting;
+        counting = (split_sync_stats_t){0};
+    }
+
+    if (state != current.state) {
+        current.state = state;
+        current.version++;
+        in_sync = false;
+    }
+
+    if (in_sync) {
+        if (timer_elapsed(last_send) < SPLIT_SYNC_HEARTBEAT_MS) return;
+    } else if (retrying) {
+        if (timer_elapsed(last_send) < SPLIT_SYNC_RETRY_MS) return;
+    }
+
+    last_send = timer_read();
+    if (transaction_rpc_send(USER_SYNC_STATE, sizeof(current), &current)) {
+        in_sync = true;
+        retrying = false;
+        counting.sent++;
+    } else {
+        in_sync = false;
+        retrying = true;
+        counting.failed++;
+    }
+}
+
+const split_sync_stats_t *split_sync_get_stats(void) {
+    return &stats;
+}
+
+bool split_sync_raw_hid(uint8_t *data, uint8_t length) {
+    if (data[0] != SPLIT_SYNC_CMD_STATS || length < 7) return false;
+    const uint16_t fields[] = {stats.passes, stats.sent, stats.failed};
+    for (uint8_t i = 0; i < 3; i++) {
+        data[1 + i * 2] = fields[i] & 0xFF;
+        data[2 + i * 2] = fields[i] >> 8;
+    }
+    return true;
+}
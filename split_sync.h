@@ -0,0 +1,39 @@
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+// Change-driven master to slave sync of a 16-bit user state word. The word
+// is sent with a version byte only when it changes, repeated at a low rate
+// as a heartbeat, and retried if a transaction fails. The slave skips a
+// payload that repeats the version and state it last applied, and applies
+// any other, so it follows a master that reset and counts from 0 again.
+
+// Transactions per second, refreshed once a second on the master
+typedef struct {
+    uint16_t passes;  // housekeeping passes, i.e. what an every-pass sender would send
+    uint16_t sent;    // transactions that went through
+    uint16_t failed;  // transactions that failed and were retried
+} split_sync_stats_t;
+
+// Raw HID command. Replies echo the command byte; fields are little endian.
+//   SPLIT_SYNC_CMD_STATS -> passes, sent, failed (u16 each), last second
+enum split_sync_commands {
+    SPLIT_SYNC_CMD_STATS = 0x64,
+};
+
+// Registers the slave handler. Call from keyboard_post_init_user.
+void split_sync_init(void);
+
+// Call from housekeeping_task_user on both halves with the current state
+// word. Does nothing on the slave.
+void split_sync_task(uint16_t state);
+
+// Last complete second of transaction counters
+const split_sync_stats_t *split_sync_get_stats(void);
+
+// Handles a raw HID request in place. Returns false for unknown commands.
+bool split_sync_raw_hid(uint8_t *data, uint8_t length);
+
+// To be implemented by the consumer. Applies a state word received from the
+// master on the slave.
+void split_sync_apply(uint16_t state);
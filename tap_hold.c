@@ -0,0 +1,134 @@
+#include "tap_hold.h"
+#include "report_batch.h"
+#include <string.h>
+
+#ifndef TAP_HOLD_TERM
+#    define TAP_HOLD_TERM 150
+#endif
+#ifndef TAP_HOLD_STREAK_MS
+#    define TAP_HOLD_STREAK_MS 100
+#endif
+#ifndef TAP_HOLD_BUFFER
+#    define TAP_HOLD_BUFFER 8
+#endif
+
+static enum {
+    th_idle,
+    th_pending,
+    th_tap,
+    th_hold,
+} state = th_idle;
+
+static tap_hold_key active;      // Entry of the key being resolved or held
+static keypos_t     active_key;
+static uint16_t     pressed_at;
+static uint16_t     last_press = 0;
+
+static keyrecord_t buffer[TAP_HOLD_BUFFER];
+static uint8_t     buffered = 0;
+static bool        replaying = false;
+
+static int8_t find_key(uint16_t keycode) {
+    for (uint8_t i = 0; i < tap_hold_key_count; i++) {
+        if (pgm_read_word(&tap_hold_keys[i].trigger) == keycode) return i;
+    }
+    return -1;
+}
+
+static inline bool same_key(keypos_t a, keypos_t b) {
+    return a.row == b.row && a.col == b.col;
+}
+
+// Halves of the split matrix
+static inline bool on_left(keypos_t key) {
+    return key.row < MATRIX_ROWS / 2;
+}
+
+static void replay_buffer(void) {
+    replaying = true;
+    for (uint8_t i = 0; i < buffered; i++) {
+        process_record(&buffer[i]);
+    }
+    replaying = false;
+    buffered  = 0;
+}
+
+// Whether a key's press is held back in the buffer
+static bool is_buffered_press(keypos_t key) {
+    for (uint8_t i = 0; i < buffered; i++) {
+        if (buffer[i].event.pressed && same_key(buffer[i].event.key, key)) return true;
+    }
+    return false;
+}
+
+static void resolve(bool hold) {
+    if (hold) {
+        // The modifier rides in the first replayed key's report
+        add_mods(MOD_BIT(active.hold));
+        report_batch_mods();
+        state = th_hold;
+    } else {
+        register_code(active.tap);
+        state = th_tap;
+    }
+    replay_buffer();
+    report_batch_flush();
+}
+
+bool process_tap_hold(uint16_t keycode, keyrecord_t *record) {
+    if (replaying) return true;
+
+    bool     pressed = record->event.pressed;
+    uint16_t since   = timer_elapsed(last_press);
+    if (pressed) last_press = timer_read();
+
+    if (state == th_pending) {
+        if (!pressed && same_key(record->event.key, active_key)) {
+            resolve(false);
+            unregister_code(active.tap);
+            state = th_idle;
+            return false;
+        }
+        // A key on the other half tapped within the hold is a chord. One
+        // that is still down when this key is released is a roll.
+        bool other_half = on_left(record->event.key) != on_left(active_key);
+        bool chord      = !pressed && other_half && is_buffered_press(record->event.key);
+        buffer[buffered++] = *record;
+        if (pressed && !other_half) {
+            resolve(false);
+        } else if (chord) {
+            resolve(true);
+        } else if (buffered == TAP_HOLD_BUFFER) {
+            resolve(false);
+        }
+        return false;
+    }
+
+    if ((state == th_tap || state == th_hold) && same_key(record->event.key, active_key)) {
+        if (!pressed) {
+            unregister_code(state == th_hold ? active.hold : active.tap);
+            state = th_idle;
+        }
+        return false;
+    }
+
+    int8_t index = find_key(keycode);
+    if (index < 0 || !pressed || state != th_idle) return true;
+
+    memcpy_P(&active, &tap_hold_keys[index], sizeof(active));
+    active_key = record->event.key;
+    pressed_at = timer_read();
+    if (since < TAP_HOLD_STREAK_MS) {
+        register_code(active.tap);
+        state = th_tap;
+    } else {
+        state = th_pending;
+    }
+    return false;
+}
+
+void tap_hold_task(void) {
+    if (state == th_pending && timer_elapsed(pressed_at) >= TAP_HOLD_TERM) {
+        resolve(true);
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+// A tap-hold key: one keycode on tap, a modifier on hold
+typedef struct {
+    uint16_t trigger;
+    uint8_t  tap;   // Basic keycode
+    uint8_t  hold;  // Modifier keycode, e.g. KC_LSFT
+} tap_hold_key;
+
+// Tap-hold resolver that decides as early as it can instead of waiting out
+// a tapping term:
+//   - pressed within TAP_HOLD_STREAK_MS of the previous key press, it is a
+//     tap straight away, so typing through it adds no latency
+//   - a key on the other half pressed and released while it is pending
+//     makes it a hold (a chord); a key pressed on the same half makes it a
+//     tap (a roll)
+//   - released while pending, it is a tap, even with other-half keys still
+//     down (a roll across the halves)
+//   - still undecided after TAP_HOLD_TERM, it is a hold
+// A hold's modifier goes out in the same report as the first replayed key.
+// Events that arrive while a key is pending are held back and replayed
+// together once it is resolved.
+//
+// Returns false if the event was consumed. Call first in
+// process_record_user.
+bool process_tap_hold(uint16_t keycode, keyrecord_t *record);
+
+// Applies the timer fallback. Call from housekeeping_task_user.
+void tap_hold_task(void);
+
+// To be implemented by the consumer. The tap-hold table, in PROGMEM, and the
+// number of entries in it.
+extern const tap_hold_key tap_hold_keys[];
+extern const uint8_t      tap_hold_key_count;
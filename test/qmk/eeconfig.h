@@ -0,0 +1,10 @@
+#pragma once
+
+#include "qmk.h"
+
+#define SIM_EEPROM_SIZE 1024
+#define SIM_EECONFIG_USER_DATABLOCK_OFFSET 64
+
+extern uint8_t sim_eeprom[SIM_EEPROM_SIZE];
+
+#define EECONFIG_USER_DATABLOCK (sim_eeprom + SIM_EECONFIG_USER_DATABLOCK_OFFSET)
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "qmk.h"
+
+uint8_t eeprom_read_byte(const uint8_t *addr);
+void    eeprom_update_byte(uint8_t *addr, uint8_t value);
+void    eeprom_read_block(void *buf, const void *addr, size_t len);
+void    eeprom_update_block(const void *buf, void *addr, size_t len);
@@ -0,0 +1,696 @@
+#include "qmk.h"
+#include "sim.h"
+#include "transactions.h"
+#include "eeconfig.h"
+#include "eeprom.h"
+#include "send_string.h"
+#include <stdlib.h>
+
+// ============================================================================
+// CLOCK
+// ============================================================================
+
+uint32_t sim_now;
+
+static uint32_t last_activity;
+
+uint16_t timer_read(void) {
+    return (uint16_t)sim_now;
+}
+
+uint32_t timer_read32(void) {
+    return sim_now;
+}
+
+uint16_t timer_elapsed(uint16_t last) {
+    return TIMER_DIFF_16(timer_read(), last);
+}
+
+uint32_t timer_elapsed32(uint32_t last) {
+    return sim_now - last;
+}
+
+void wait_ms(uint16_t ms) {
+    sim_now += ms;
+    sim_counters.waits++;
+}
+
+void wait_us(uint16_t us) {
+    (void)us;
+}
+
+uint32_t last_input_activity_elapsed(void) {
+    return sim_now - last_activity;
+}
+
+// ============================================================================
+// SPLIT
+// ============================================================================
+
+bool sim_master = true;
+bool sim_left   = true;
+
+bool is_keyboard_master(void) {
+    return sim_master;
+}
+
+bool is_keyboard_left(void) {
+    return sim_left;
+}
+
+bool    sim_transactions_ok = true;
+uint8_t sim_transaction_data[SIM_TRANSACTION_COUNT][32];
+uint8_t sim_transaction_length[SIM_TRANSACTION_COUNT];
+
+static slave_callback_t transaction_handlers[SIM_TRANSACTION_COUNT];
+
+void transaction_register_rpc(int8_t transaction_id, slave_callback_t callback) {
+    transaction_handlers[transaction_id] = callback;
+}
+
+bool transaction_rpc_send(int8_t transaction_id, uint8_t initiator2target_buffer_size, const void *initiator2target_buffer) {
+    sim_counters.transactions++;
+    sim_counters.transaction_bytes += initiator2target_buffer_size;
+    uint8_t length = initiator2target_buffer_size;
+    if (length > sizeof(sim_transaction_data[0])) length = sizeof(sim_transaction_data[0]);
+    memcpy(sim_transaction_data[transaction_id], initiator2target_buffer, length);
+    sim_transaction_length[transaction_id] = length;
+    return sim_transactions_ok;
+}
+
+void sim_transaction_receive(int8_t id, const void *data, uint8_t length) {
+    if (transaction_handlers[id]) {
+        transaction_handlers[id](length, data, 0, NULL);
+    }
+}
+
+// ============================================================================
+// EEPROM
+// ============================================================================
+
+uint8_t sim_eeprom[SIM_EEPROM_SIZE];
+
+uint8_t eeprom_read_byte(const uint8_t *addr) {
+    return *addr;
+}
+
+void eeprom_update_byte(uint8_t *addr, uint8_t value) {
+    if (*addr != value) {
+        *addr = value;
+        sim_counters.eeprom_writes++;
+    }
+}
+
+void eeprom_read_block(void *buf, const void *addr, size_t len) {
+    memcpy(buf, addr, len);
+}
+
+void eeprom_update_block(const void *buf, void *addr, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        eeprom_update_byte((uint8_t *)addr + i, ((const uint8_t *)buf)[i]);
+    }
+}
+
+// ============================================================================
+// SEND STRING
+// ============================================================================
+
+// US ANSI, as in QMK's send_string_keycodes
+// clang-format off
+const uint8_t ascii_to_shift_lut[16] = {
+    0x00, 0x00, 0x00, 0x00, 0x7E, 0x0F, 0x00, 0xD4,
+    0xFF, 0xFF, 0xFF, 0xC7, 0x00, 0x00, 0x00, 0x78,
+};
+
+const uint8_t ascii_to_keycode_lut[128] = {
+    KC_NO,   KC_NO,   KC_NO,   KC_NO,   KC_NO,   KC_NO,   KC_NO,   KC_NO,
+    KC_BSPC, KC_TAB,  KC_ENT,  KC_NO,   KC_NO,   KC_NO,   KC_NO,   KC_NO,
+    KC_NO,   KC_NO,   KC_NO,   KC_NO,   KC_NO,   KC_NO,   KC_NO,   KC_NO,
+    KC_NO,   KC_NO,   KC_NO,   KC_ESC,  KC_NO,   KC_NO,   KC_NO,   KC_NO,
+    KC_SPC,  KC_1,    KC_QUOT, KC_3,    KC_4,    KC_5,    KC_7,    KC_QUOT,
+    KC_9,    KC_0,    KC_8,    KC_EQL,  KC_COMM, KC_MINS, KC_DOT,  KC_SLSH,
+    KC_0,    KC_1,    KC_2,    KC_3,    KC_4,    KC_5,    KC_6,    KC_7,
+    KC_8,    KC_9,    KC_SCLN, KC_SCLN, KC_COMM, KC_EQL,  KC_DOT,  KC_SLSH,
+    KC_2,    KC_A,    KC_B,    KC_C,    KC_D,    KC_E,    KC_F,    KC_G,
+    KC_H,    KC_I,    KC_J,    KC_K,    KC_L,    KC_M,    KC_N,    KC_O,
+    KC_P,    KC_Q,    KC_R,    KC_S,    KC_T,    KC_U,    KC_V,    KC_W,
+    KC_X,    KC_Y,    KC_Z,    KC_LBRC, KC_BSLS, KC_RBRC, KC_6,    KC_MINS,
+    KC_GRV,  KC_A,    KC_B,    KC_C,    KC_D,    KC_E,    KC_F,    KC_G,
+    KC_H,    KC_I,    KC_J,    KC_K,    KC_L,    KC_M,    KC_N,    KC_O,
+    KC_P,    KC_Q,    KC_R,    KC_S,    KC_T,    KC_U,    KC_V,    KC_W,
+    KC_X,    KC_Y,    KC_Z,    KC_LBRC, KC_BSLS, KC_RBRC, KC_GRV,  KC_DEL,
+};
+// clang-format on
+
+// ============================================================================
+// HID
+// ============================================================================
+
+sim_counters_t      sim_counters;
+sim_keyboard_log_t *sim_keyboard_log;
+size_t              sim_keyboard_log_count;
+sim_mouse_log_t    *sim_mouse_log;
+size_t              sim_mouse_log_count;
+uint8_t             sim_raw_hid_reply[32];
+uint8_t             sim_raw_hid_reply_length;
+
+static size_t            keyboard_log_capacity;
+static size_t            mouse_log_capacity;
+static report_keyboard_t report;
+static report_keyboard_t last_report;
+static uint8_t           real_mods;
+static uint8_t           weak_mods;
+
+report_keyboard_t *keyboard_report = &report;
+
+void sim_clear_output(void) {
+    sim_keyboard_log_count   = 0;
+    sim_mouse_log_count      = 0;
+    sim_raw_hid_reply_length = 0;
+}
+
+// Only changed reports reach the host, as in QMK's send_6kro_report()
+void send_keyboard_report(void) {
+    report.mods = real_mods | weak_mods;
+    if (memcmp(&report, &last_report, sizeof(report)) == 0) return;
+    last_report = report;
+    sim_counters.reports++;
+    if (sim_keyboard_log_count == keyboard_log_capacity) {
+        keyboard_log_capacity = keyboard_log_capacity ? keyboard_log_capacity * 2 : 256;
+        sim_keyboard_log      = realloc(sim_keyboard_log, keyboard_log_capacity * sizeof(*sim_keyboard_log));
+    }
+    sim_keyboard_log[sim_keyboard_log_count++] = (sim_keyboard_log_t){sim_now, report};
+}
+
+void host_mouse_send(report_mouse_t *mouse) {
+    sim_counters.mouse_reports++;
+    if (sim_mouse_log_count == mouse_log_capacity) {
+        mouse_log_capacity = mouse_log_capacity ? mouse_log_capacity * 2 : 256;
+        sim_mouse_log      = realloc(sim_mouse_log, mouse_log_capacity * sizeof(*sim_mouse_log));
+    }
+    sim_mouse_log[sim_mouse_log_count++] = (sim_mouse_log_t){sim_now, *mouse};
+}
+
+void raw_hid_send(uint8_t *data, uint8_t length) {
+    if (length > sizeof(sim_raw_hid_reply)) length = sizeof(sim_raw_hid_reply);
+    memcpy(sim_raw_hid_reply, data, length);
+    sim_raw_hid_reply_length = length;
+}
+
+bool sim_host_key(uint8_t kc) {
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (last_report.keys[i] == kc) return true;
+    }
+    return false;
+}
+
+uint8_t sim_host_mods(void) {
+    return last_report.mods;
+}
+
+static void add_key(uint8_t kc) {
+    uint8_t free_slot = KEYBOARD_REPORT_KEYS;
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (report.keys[i] == kc) return;
+        if (!report.keys[i] && free_slot == KEYBOARD_REPORT_KEYS) free_slot = i;
+    }
+    if (free_slot < KEYBOARD_REPORT_KEYS) report.keys[free_slot] = kc;
+}
+
+static void del_key(uint8_t kc) {
+    for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+        if (report.keys[i] == kc) report.keys[i] = 0;
+    }
+}
+
+void register_code(uint8_t kc) {
+    sim_counters.code_calls++;
+    if (IS_MODIFIER_KEYCODE(kc)) {
+        real_mods |= MOD_BIT(kc);
+    } else if (kc >= KC_A && kc < KC_MUTE) {
+        add_key(kc);
+    } else {
+        return;
+    }
+    send_keyboard_report();
+}
+
+void unregister_code(uint8_t kc) {
+    sim_counters.code_calls++;
+    if (IS_MODIFIER_KEYCODE(kc)) {
+        real_mods &= ~MOD_BIT(kc);
+    } else if (kc >= KC_A && kc < KC_MUTE) {
+        del_key(kc);
+    } else {
+        return;
+    }
+    send_keyboard_report();
+}
+
+void tap_code(uint8_t kc) {
+    register_code(kc);
+    unregister_code(kc);
+}
+
+// Only left-hand mod bits are used by the keymap's shifted keycodes
+void register_code16(uint16_t kc) {
+    uint8_t mods = (kc >> 8) & 0x1F;
+    if (mods) {
+        weak_mods |= mods;
+        send_keyboard_report();
+    }
+    register_code(kc & 0xFF);
+}
+
+void unregister_code16(uint16_t kc) {
+    uint8_t mods = (kc >> 8) & 0x1F;
+    unregister_code(kc & 0xFF);
+    if (mods) {
+        weak_mods &= ~mods;
+        send_keyboard_report();
+    }
+}
+
+uint8_t get_mods(void) {
+    return real_mods;
+}
+
+void add_mods(uint8_t mods) {
+    sim_counters.mod_calls++;
+    real_mods |= mods;
+}
+
+void del_mods(uint8_t mods) {
+    sim_counters.mod_calls++;
+    real_mods &= ~mods;
+}
+
+void set_mods(uint8_t mods) {
+    sim_counters.mod_calls++;
+    real_mods = mods;
+}
+
+void clear_mods(void) {
+    sim_counters.mod_calls++;
+    real_mods = 0;
+}
+
+uint8_t get_weak_mods(void) {
+    return weak_mods;
+}
+
+void add_weak_mods(uint8_t mods) {
+    sim_counters.mod_calls++;
+    weak_mods |= mods;
+}
+
+void del_weak_mods(uint8_t mods) {
+    sim_counters.mod_calls++;
+    weak_mods &= ~mods;
+}
+
+void clear_weak_mods(void) {
+    sim_counters.mod_calls++;
+    weak_mods = 0;
+}
+
+// ============================================================================
+// LAYERS
+// ============================================================================
+
+layer_state_t layer_state;
+layer_state_t default_layer_state = 1;
+
+uint8_t get_highest_layer(layer_state_t state) {
+    for (int8_t i = 31; i > 0; i--) {
+        if (state & (1UL << i)) return i;
+    }
+    return 0;
+}
+
+bool layer_state_is(uint8_t layer) {
+    return layer ? (layer_state & (1UL << layer)) != 0 : layer_state == 0;
+}
+
+void layer_state_set(layer_state_t state) {
+    state       = layer_state_set_user(state);
+    layer_state = state;
+}
+
+void layer_on(uint8_t layer) {
+    layer_state_set(layer_state | (1UL << layer));
+}
+
+void layer_off(uint8_t layer) {
+    layer_state_set(layer_state & ~(1UL << layer));
+}
+
+void layer_move(uint8_t layer) {
+    layer_state_set(1UL << layer);
+}
+
+void layer_clear(void) {
+    layer_state_set(0);
+}
+
+// ============================================================================
+// ACTIONS
+// ============================================================================
+
+// Layer each key was pressed on, so its release resolves to the same keycode
+static uint8_t source_layers[MATRIX_ROWS][MATRIX_COLS];
+
+static uint16_t keymap_keycode(uint8_t layer, keypos_t key) {
+    if (layer >= DYNAMIC_KEYMAP_LAYER_COUNT) return KC_TRNS;
+    return keymaps[layer][key.row][key.col];
+}
+
+static uint8_t layer_switch_get_layer(keypos_t key) {
+    layer_state_t layers = layer_state | default_layer_state;
+    for (int8_t i = 31; i >= 0; i--) {
+        if ((layers & (1UL << i)) && keymap_keycode(i, key) != KC_TRNS) return i;
+    }
+    return 0;
+}
+
+static uint16_t record_keycode(keyrecord_t *record) {
+    keypos_t key = record->event.key;
+    if (record->event.pressed) {
+        source_layers[key.row][key.col] = layer_switch_get_layer(key);
+    }
+    return keymap_keycode(source_layers[key.row][key.col], key);
+}
+
+static void process_action(uint16_t keycode, bool pressed) {
+    if (IS_QK_MOMENTARY(keycode)) {
+        if (pressed) {
+            layer_on(QK_MOMENTARY_GET_LAYER(keycode));
+        } else {
+            layer_off(QK_MOMENTARY_GET_LAYER(keycode));
+        }
+    } else if (IS_QK_MODS(keycode) || (keycode >= KC_A && keycode <= KC_RGUI)) {
+        if (pressed) {
+            register_code16(keycode);
+        } else {
+            unregister_code16(keycode);
+        }
+    }
+}
+
+// Reactive keys: LED hits as QMK's process_rgb_matrix() records them
+uint8_t           get_led_from_matrix(uint8_t row, uint8_t col);
+static last_hit_t last_hit_buffer;
+last_hit_t        g_last_hit_tracker;
+
+static void record_hit(keypos_t key) {
+    uint8_t led = get_led_from_matrix(key.row, key.col);
+    if (led >= RGB_MATRIX_LED_COUNT) return;
+    if (last_hit_buffer.count + 1 > LED_HITS_TO_REMEMBER) {
+        memmove(&last_hit_buffer.index[0], &last_hit_buffer.index[1], LED_HITS_TO_REMEMBER - 1);
+        memmove(&last_hit_buffer.tick[0], &last_hit_buffer.tick[1], (LED_HITS_TO_REMEMBER - 1) * sizeof(uint16_t));
+        last_hit_buffer.count = LED_HITS_TO_REMEMBER - 1;
+    }
+    last_hit_buffer.index[last_hit_buffer.count] = led;
+    last_hit_buffer.tick[last_hit_buffer.count]  = 0;
+    last_hit_buffer.count++;
+}
+
+void process_record(keyrecord_t *record) {
+    uint16_t keycode = record_keycode(record);
+    if (record->event.pressed) record_hit(record->event.key);
+    if (!process_record_user(keycode, record)) return;
+    process_action(keycode, record->event.pressed);
+    post_process_record_user(keycode, record);
+}
+
+// ============================================================================
+// COLOR
+// ============================================================================
+
+// QMK's hsv_to_rgb() without the CIE curve
+RGB hsv_to_rgb(HSV hsv) {
+    if (hsv.s == 0) return (RGB){hsv.v, hsv.v, hsv.v};
+
+    uint16_t h = hsv.h, s = hsv.s, v = hsv.v;
+    uint8_t  region    = h * 6 / 255;
+    uint8_t  remainder = (h * 2 - region * 85) * 3;
+    uint8_t  p         = (v * (255 - s)) >> 8;
+    uint8_t  q         = (v * (255 - ((s * remainder) >> 8))) >> 8;
+    uint8_t  t         = (v * (255 - ((s * (255 - remainder)) >> 8))) >> 8;
+    switch (region) {
+        case 6:
+        case 0:
+            return (RGB){v, t, p};
+        case 1:
+            return (RGB){q, v, p};
+        case 2:
+            return (RGB){p, v, t};
+        case 3:
+            return (RGB){p, q, v};
+        case 4:
+            return (RGB){t, p, v};
+        default:
+            return (RGB){v, p, q};
+    }
+}
+
+uint8_t qadd8(uint8_t i, uint8_t j) {
+    unsigned t = i + j;
+    return t > 255 ? 255 : t;
+}
+
+// lib8tion with FASTLED_SCALE8_FIXED
+uint8_t scale8(uint8_t i, uint8_t scale) {
+    return ((uint16_t)i * (1 + (uint16_t)scale)) >> 8;
+}
+
+uint16_t scale16by8(uint16_t i, uint8_t scale) {
+    return ((uint32_t)i * (1 + (uint32_t)scale)) >> 8;
+}
+
+// ============================================================================
+// RGB MATRIX
+// ============================================================================
+
+RGB sim_leds[RGB_MATRIX_LED_COUNT];
+
+static RGB led_buffer[RGB_MATRIX_LED_COUNT];
+
+static struct {
+    bool    enable;
+    uint8_t mode;
+    HSV     hsv;
+    uint8_t speed;
+} rgb_config = {true, RGB_MATRIX_DEFAULT_MODE, {0, 255, RGB_MATRIX_DEFAULT_VAL}, 128};
+
+static enum { STARTING, RENDERING, FLUSHING, SYNCING } rgb_task_state = SYNCING;
+
+static effect_params_t rgb_params;
+static uint8_t         rgb_last_effect;
+static bool            rgb_last_enable;
+static uint32_t        rgb_task_timer;
+static uint32_t        rgb_hit_timer;
+static bool            rgb_frame_flushed;
+
+void rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
+    const uint8_t split[2] = RGB_MATRIX_SPLIT;
+    if (index < 0 || index >= RGB_MATRIX_LED_COUNT) return;
+    if (is_keyboard_left() != (index < split[0])) return;
+    led_buffer[index] = (RGB){red, green, blue};
+}
+
+void rgb_matrix_set_color_all(uint8_t red, uint8_t green, uint8_t blue) {
+    for (int i = 0; i < RGB_MATRIX_LED_COUNT; i++) {
+        rgb_matrix_set_color(i, red, green, blue);
+    }
+}
+
+bool rgb_matrix_check_finished_leds(uint8_t led_idx) {
+    const uint8_t split[2] = RGB_MATRIX_SPLIT;
+    if (is_keyboard_left()) return led_idx < split[0];
+    return led_idx < RGB_MATRIX_LED_COUNT;
+}
+
+void rgb_matrix_enable_noeeprom(void) {
+    if (!rgb_config.enable) rgb_task_state = STARTING;
+    rgb_config.enable = true;
+}
+
+void rgb_matrix_disable_noeeprom(void) {
+    if (rgb_config.enable) rgb_task_state = STARTING;
+    rgb_config.enable = false;
+}
+
+bool rgb_matrix_is_enabled(void) {
+    return rgb_config.enable;
+}
+
+void rgb_matrix_mode_noeeprom(uint8_t mode) {
+    if (!rgb_config.enable) return;
+    if (mode < 1) mode = 1;
+    if (mode >= RGB_MATRIX_EFFECT_MAX) mode = RGB_MATRIX_EFFECT_MAX - 1;
+    rgb_config.mode = mode;
+    rgb_task_state  = STARTING;
+}
+
+uint8_t rgb_matrix_get_mode(void) {
+    return rgb_config.mode;
+}
+
+void rgb_matrix_sethsv_noeeprom(uint8_t hue, uint8_t sat, uint8_t val) {
+    if (!rgb_config.enable) return;
+    if (val > RGB_MATRIX_MAXIMUM_BRIGHTNESS) val = RGB_MATRIX_MAXIMUM_BRIGHTNESS;
+    rgb_config.hsv = (HSV){hue, sat, val};
+}
+
+HSV rgb_matrix_get_hsv(void) {
+    return rgb_config.hsv;
+}
+
+void rgb_matrix_set_speed_noeeprom(uint8_t speed) {
+    rgb_config.speed = speed;
+}
+
+uint8_t rgb_matrix_get_speed(void) {
+    return rgb_config.speed;
+}
+
+static bool effect_none(effect_params_t *params) {
+    RGB_MATRIX_USE_LIMITS(led_min, led_max);
+    for (uint8_t i = led_min; i < led_max; i++) {
+        rgb_matrix_set_color(i, 0, 0, 0);
+    }
+    return rgb_matrix_check_finished_leds(led_max);
+}
+
+static bool effect_solid_color(effect_params_t *params) {
+    RGB_MATRIX_USE_LIMITS(led_min, led_max);
+    RGB rgb = hsv_to_rgb(rgb_config.hsv);
+    for (uint8_t i = led_min; i < led_max; i++) {
+        rgb_matrix_set_color(i, rgb.r, rgb.g, rgb.b);
+    }
+    return rgb_matrix_check_finished_leds(led_max);
+}
+
+#define RGB_MATRIX_EFFECT(name)
+#define RGB_MATRIX_CUSTOM_EFFECT_IMPLS
+#include "rgb_matrix_user.inc"
+#undef RGB_MATRIX_CUSTOM_EFFECT_IMPLS
+#undef RGB_MATRIX_EFFECT
+
+// Hit ticks age with the clock, then the renderer gets a snapshot per frame
+static void rgb_task_timers(void) {
+    uint32_t delta = sim_now - rgb_hit_timer;
+    rgb_hit_timer  = sim_now;
+    for (uint8_t i = 0; i < last_hit_buffer.count; i++) {
+        uint32_t tick           = last_hit_buffer.tick[i] + delta;
+        last_hit_buffer.tick[i] = tick > UINT16_MAX ? UINT16_MAX : tick;
+    }
+}
+
+static void rgb_task_render(uint8_t effect) {
+    bool rendering  = false;
+    rgb_params.init = effect != rgb_last_effect || rgb_config.enable != rgb_last_enable;
+    switch (effect) {
+        case RGB_MATRIX_NONE:
+            rendering = effect_none(&rgb_params);
+            break;
+        case RGB_MATRIX_SOLID_COLOR:
+            rendering = effect_solid_color(&rgb_params);
+            break;
+        case RGB_MATRIX_CUSTOM_LAYER_OVERLAY:
+            rendering = LAYER_OVERLAY(&rgb_params);
+            break;
+    }
+    sim_counters.chunks++;
+    rgb_params.iter++;
+    if (!rendering) {
+        rgb_task_state = FLUSHING;
+        if (!rgb_params.init && effect == RGB_MATRIX_NONE) {
+            rgb_task_state = SYNCING;
+        }
+    }
+}
+
+void sim_rgb_task(void) {
+    rgb_task_timers();
+    uint8_t effect = rgb_config.enable ? rgb_config.mode : RGB_MATRIX_NONE;
+    switch (rgb_task_state) {
+        case STARTING:
+            rgb_params.iter    = 0;
+            g_last_hit_tracker = last_hit_buffer;
+            rgb_task_state     = RENDERING;
+            break;
+        case RENDERING:
+            rgb_task_render(effect);
+            break;
+        case FLUSHING:
+            rgb_last_effect = effect;
+            rgb_last_enable = rgb_config.enable;
+            memcpy(sim_leds, led_buffer, sizeof(sim_leds));
+            sim_counters.frames++;
+            rgb_frame_flushed = true;
+            rgb_task_timer    = sim_now;
+            rgb_task_state    = SYNCING;
+            break;
+        case SYNCING:
+            if (timer_elapsed32(rgb_task_timer) >= RGB_MATRIX_LED_FLUSH_LIMIT) {
+                rgb_task_state = STARTING;
+            }
+            break;
+    }
+}
+
+void sim_render_frame(void) {
+    if (rgb_task_state == SYNCING) rgb_task_state = STARTING;
+    rgb_frame_flushed = false;
+    // A frame that needs nothing flushed ends in SYNCING without one
+    for (int steps = 0; !rgb_frame_flushed && steps < 2 * RGB_MATRIX_LED_COUNT + 4; steps++) {
+        sim_rgb_task();
+        if (rgb_task_state == SYNCING && !rgb_frame_flushed) break;
+    }
+}
+
+// ============================================================================
+// MAIN LOOP
+// ============================================================================
+
+void sim_boot(void) {
+    rgb_hit_timer  = sim_now;
+    rgb_task_timer = sim_now;
+    rgb_task_state = STARTING;
+    keyboard_post_init_user();
+    sim_scan();
+}
+
+void sim_scan(void) {
+    sim_rgb_task();
+    housekeeping_task_user();
+    sim_now++;
+}
+
+void sim_run(uint32_t ms) {
+    uint32_t end = sim_now + ms;
+    while ((int32_t)(end - sim_now) > 0) {
+        sim_scan();
+    }
+}
+
+void sim_input_activity(void) {
+    last_activity = sim_now;
+}
+
+void sim_key(uint8_t row, uint8_t col, bool pressed) {
+    last_activity = sim_now;
+    sim_counters.events++;
+    keyrecord_t record = {
+        .event = {.key = {.col = col, .row = row}, .time = (uint16_t)(sim_now | 1), .type = 1, .pressed = pressed},
+    };
+    process_record(&record);
+}
+
+void sim_tap(uint8_t row, uint8_t col, uint32_t hold_ms) {
+    sim_key(row, col, true);
+    sim_run(hold_ms);
+    sim_key(row, col, false);
+}
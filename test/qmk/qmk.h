@@ -0,0 +1,319 @@
+#pragma once
+
+// Stand-in for QMK_KEYBOARD_H in the host build. Declares the subset of the
+// QMK API the keymap uses, with the same names and keycode values, so the
+// keymap sources compile unchanged. qmk.c implements it on top of a virtual
+// clock and records what the firmware sends.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#define SPLIT_KEYBOARD
+#define RGB_MATRIX_ENABLE
+#define RGB_MATRIX_KEYPRESSES
+
+#define MATRIX_ROWS 8
+#define MATRIX_COLS 6
+#define RGB_MATRIX_LED_COUNT 54
+#define RGB_MATRIX_MAXIMUM_BRIGHTNESS 120  // From the keyboard's info.json
+
+#include "config.h"
+
+// ----------------------------------------------------------------------------
+// Platform
+// ----------------------------------------------------------------------------
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define memcpy_P(dst, src, n) memcpy((dst), (src), (n))
+
+uint16_t timer_read(void);
+uint32_t timer_read32(void);
+uint16_t timer_elapsed(uint16_t last);
+uint32_t timer_elapsed32(uint32_t last);
+#define TIMER_DIFF_16(a, b) ((uint16_t)((a) - (b)))
+
+void wait_ms(uint16_t ms);
+void wait_us(uint16_t us);
+
+uint32_t last_input_activity_elapsed(void);
+
+// ----------------------------------------------------------------------------
+// Keycodes
+// ----------------------------------------------------------------------------
+
+enum qk_keycode_defines {
+    KC_NO   = 0x0000,
+    KC_TRNS = 0x0001,
+    KC_A    = 0x0004,
+    KC_B, KC_C, KC_D, KC_E, KC_F, KC_G, KC_H, KC_I, KC_J, KC_K, KC_L, KC_M,
+    KC_N, KC_O, KC_P, KC_Q, KC_R, KC_S, KC_T, KC_U, KC_V, KC_W, KC_X, KC_Y, KC_Z,
+    KC_1, KC_2, KC_3, KC_4, KC_5, KC_6, KC_7, KC_8, KC_9, KC_0,
+    KC_ENT, KC_ESC, KC_BSPC, KC_TAB, KC_SPC, KC_MINS, KC_EQL, KC_LBRC, KC_RBRC,
+    KC_BSLS, KC_NUHS, KC_SCLN, KC_QUOT, KC_GRV, KC_COMM, KC_DOT, KC_SLSH, KC_CAPS,
+    KC_F1, KC_F2, KC_F3, KC_F4, KC_F5, KC_F6, KC_F7, KC_F8, KC_F9, KC_F10, KC_F11, KC_F12,
+    KC_PSCR, KC_SCRL, KC_PAUS, KC_INS, KC_HOME, KC_PGUP, KC_DEL, KC_END, KC_PGDN,
+    KC_RGHT, KC_LEFT, KC_DOWN, KC_UP,
+
+    KC_MUTE = 0x00A8,
+    KC_VOLU,
+    KC_VOLD,
+    KC_MNXT,
+    KC_MPRV,
+    KC_MSTP,
+    KC_MPLY,
+
+    KC_MS_U = 0x00CD,
+    KC_MS_D, KC_MS_L, KC_MS_R,
+    KC_BTN1, KC_BTN2, KC_BTN3, KC_BTN4, KC_BTN5, KC_BTN6, KC_BTN7, KC_BTN8,
+    KC_WH_U, KC_WH_D, KC_WH_L, KC_WH_R,
+    KC_ACL0, KC_ACL1, KC_ACL2,
+
+    KC_LCTL = 0x00E0,
+    KC_LSFT, KC_LALT, KC_LGUI, KC_RCTL, KC_RSFT, KC_RALT, KC_RGUI,
+
+    QK_LMODS         = 0x0100,
+    QK_MOMENTARY     = 0x5220,
+    QK_MOMENTARY_MAX = 0x523F,
+    QK_BOOT          = 0x7C00,
+    QK_USER          = 0x7E40,
+};
+
+#define SAFE_RANGE QK_USER
+#define XXXXXXX KC_NO
+#define _______ KC_TRNS
+#define KC_RIGHT KC_RGHT
+#define KC_LCMD KC_LGUI
+
+#define LSFT(kc) (0x0200 | (kc))
+#define KC_EXLM LSFT(KC_1)
+#define KC_AT LSFT(KC_2)
+#define KC_HASH LSFT(KC_3)
+#define KC_DLR LSFT(KC_4)
+#define KC_PERC LSFT(KC_5)
+#define KC_CIRC LSFT(KC_6)
+#define KC_AMPR LSFT(KC_7)
+#define KC_ASTR LSFT(KC_8)
+#define KC_LPRN LSFT(KC_9)
+#define KC_RPRN LSFT(KC_0)
+#define KC_UNDS LSFT(KC_MINS)
+#define KC_PLUS LSFT(KC_EQL)
+#define KC_LCBR LSFT(KC_LBRC)
+#define KC_RCBR LSFT(KC_RBRC)
+#define KC_PIPE LSFT(KC_BSLS)
+#define KC_COLN LSFT(KC_SCLN)
+#define KC_DQUO LSFT(KC_QUOT)
+#define KC_TILD LSFT(KC_GRV)
+#define KC_LABK LSFT(KC_COMM)
+#define KC_RABK LSFT(KC_DOT)
+#define KC_QUES LSFT(KC_SLSH)
+
+#define MO(layer) (QK_MOMENTARY | ((layer) & 0x1F))
+#define IS_QK_MOMENTARY(kc) ((kc) >= QK_MOMENTARY && (kc) <= QK_MOMENTARY_MAX)
+#define QK_MOMENTARY_GET_LAYER(kc) ((kc) & 0x1F)
+#define IS_QK_MODS(kc) ((kc) >= QK_LMODS && (kc) < 0x2000)
+#define IS_MODIFIER_KEYCODE(kc) ((kc) >= KC_LCTL && (kc) <= KC_RGUI)
+#define IS_MOUSE_KEYCODE(kc) ((kc) >= KC_MS_U && (kc) <= KC_ACL2)
+#define MOD_BIT(kc) ((uint8_t)(1 << ((kc) & 0x7)))
+#define MOD_MASK_SHIFT (MOD_BIT(KC_LSFT) | MOD_BIT(KC_RSFT))
+
+// Corne 3x6+3: rows 0-3 are the left half, rows 4-7 the right half with its
+// columns mirrored
+// clang-format off
+#define LAYOUT_split_3x6_3( \
+    L00, L01, L02, L03, L04, L05,           R00, R01, R02, R03, R04, R05, \
+    L10, L11, L12, L13, L14, L15,           R10, R11, R12, R13, R14, R15, \
+    L20, L21, L22, L23, L24, L25,           R20, R21, R22, R23, R24, R25, \
+                        L30, L31, L32, R30, R31, R32 \
+) { \
+    { L00, L01, L02, L03, L04, L05 }, \
+    { L10, L11, L12, L13, L14, L15 }, \
+    { L20, L21, L22, L23, L24, L25 }, \
+    { KC_NO, KC_NO, KC_NO, L30, L31, L32 }, \
+    { R05, R04, R03, R02, R01, R00 }, \
+    { R15, R14, R13, R12, R11, R10 }, \
+    { R25, R24, R23, R22, R21, R20 }, \
+    { KC_NO, KC_NO, KC_NO, R32, R31, R30 } \
+}
+// clang-format on
+
+// ----------------------------------------------------------------------------
+// Actions and layers
+// ----------------------------------------------------------------------------
+
+typedef struct {
+    uint8_t col;
+    uint8_t row;
+} keypos_t;
+
+typedef struct {
+    keypos_t key;
+    uint16_t time;
+    uint8_t  type;
+    bool     pressed;
+} keyevent_t;
+
+typedef struct {
+    bool    interrupted : 1;
+    bool    reserved2 : 1;
+    bool    reserved1 : 1;
+    bool    reserved0 : 1;
+    uint8_t count : 4;
+} tap_t;
+
+typedef struct {
+    keyevent_t event;
+    tap_t      tap;
+} keyrecord_t;
+
+typedef uint32_t layer_state_t;
+
+extern layer_state_t layer_state;
+extern layer_state_t default_layer_state;
+
+uint8_t get_highest_layer(layer_state_t state);
+bool    layer_state_is(uint8_t layer);
+void    layer_state_set(layer_state_t state);
+void    layer_on(uint8_t layer);
+void    layer_off(uint8_t layer);
+void    layer_move(uint8_t layer);
+void    layer_clear(void);
+
+// Runs a key event through the keymap hooks and the default action, as
+// QMK's process_record does
+void process_record(keyrecord_t *record);
+
+// Keymap hooks the host build calls
+bool          process_record_user(uint16_t keycode, keyrecord_t *record);
+void          post_process_record_user(uint16_t keycode, keyrecord_t *record);
+layer_state_t layer_state_set_user(layer_state_t state);
+void          keyboard_post_init_user(void);
+void          housekeeping_task_user(void);
+
+extern const uint16_t keymaps[][MATRIX_ROWS][MATRIX_COLS];
+
+// ----------------------------------------------------------------------------
+// HID
+// ----------------------------------------------------------------------------
+
+#define KEYBOARD_REPORT_KEYS 6
+
+typedef struct {
+    uint8_t mods;
+    uint8_t reserved;
+    uint8_t keys[KEYBOARD_REPORT_KEYS];
+} report_keyboard_t;
+
+typedef struct {
+    uint8_t buttons;
+    int8_t  x;
+    int8_t  y;
+    int8_t  v;
+    int8_t  h;
+} report_mouse_t;
+
+extern report_keyboard_t *keyboard_report;
+
+void    register_code(uint8_t kc);
+void    unregister_code(uint8_t kc);
+void    tap_code(uint8_t kc);
+void    register_code16(uint16_t kc);
+void    unregister_code16(uint16_t kc);
+uint8_t get_mods(void);
+void    add_mods(uint8_t mods);
+void    del_mods(uint8_t mods);
+void    set_mods(uint8_t mods);
+void    clear_mods(void);
+uint8_t get_weak_mods(void);
+void    add_weak_mods(uint8_t mods);
+void    del_weak_mods(uint8_t mods);
+void    clear_weak_mods(void);
+void    send_keyboard_report(void);
+void    host_mouse_send(report_mouse_t *report);
+
+void raw_hid_send(uint8_t *data, uint8_t length);
+void raw_hid_receive(uint8_t *data, uint8_t length);
+
+// ----------------------------------------------------------------------------
+// Split
+// ----------------------------------------------------------------------------
+
+bool is_keyboard_master(void);
+bool is_keyboard_left(void);
+
+// ----------------------------------------------------------------------------
+// Color and RGB matrix
+// ----------------------------------------------------------------------------
+
+typedef struct {
+    uint8_t h;
+    uint8_t s;
+    uint8_t v;
+} HSV;
+
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} RGB;
+
+RGB hsv_to_rgb(HSV hsv);
+
+uint8_t  qadd8(uint8_t i, uint8_t j);
+uint8_t  scale8(uint8_t i, uint8_t scale);
+uint16_t scale16by8(uint16_t i, uint8_t scale);
+
+enum rgb_matrix_effects {
+    RGB_MATRIX_NONE = 0,
+    RGB_MATRIX_SOLID_COLOR,
+    RGB_MATRIX_CUSTOM_LAYER_OVERLAY,
+    RGB_MATRIX_EFFECT_MAX
+};
+
+typedef struct {
+    uint8_t iter;
+    bool    init;
+} effect_params_t;
+
+#ifndef RGB_MATRIX_LED_PROCESS_LIMIT
+#    define RGB_MATRIX_LED_PROCESS_LIMIT RGB_MATRIX_LED_COUNT
+#endif
+
+// As QMK defines it with RGB_MATRIX_SPLIT and a process limit
+#define RGB_MATRIX_USE_LIMITS(min, max)                                                   \
+    uint8_t min = RGB_MATRIX_LED_PROCESS_LIMIT * params->iter;                            \
+    uint8_t max = min + RGB_MATRIX_LED_PROCESS_LIMIT;                                     \
+    if (max > RGB_MATRIX_LED_COUNT) max = RGB_MATRIX_LED_COUNT;                           \
+    uint8_t k_rgb_matrix_split[2] = RGB_MATRIX_SPLIT;                                     \
+    if (is_keyboard_left() && (max > k_rgb_matrix_split[0])) max = k_rgb_matrix_split[0]; \
+    if (!(is_keyboard_left()) && (min < k_rgb_matrix_split[0])) min = k_rgb_matrix_split[0];
+
+bool rgb_matrix_check_finished_leds(uint8_t led_idx);
+
+void    rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue);
+void    rgb_matrix_set_color_all(uint8_t red, uint8_t green, uint8_t blue);
+void    rgb_matrix_enable_noeeprom(void);
+void    rgb_matrix_disable_noeeprom(void);
+bool    rgb_matrix_is_enabled(void);
+void    rgb_matrix_mode_noeeprom(uint8_t mode);
+uint8_t rgb_matrix_get_mode(void);
+void    rgb_matrix_sethsv_noeeprom(uint8_t hue, uint8_t sat, uint8_t val);
+HSV     rgb_matrix_get_hsv(void);
+void    rgb_matrix_set_speed_noeeprom(uint8_t speed);
+uint8_t rgb_matrix_get_speed(void);
+
+#define LED_HITS_TO_REMEMBER 8
+
+typedef struct {
+    uint8_t  count;
+    uint8_t  x[LED_HITS_TO_REMEMBER];
+    uint8_t  y[LED_HITS_TO_REMEMBER];
+    uint8_t  index[LED_HITS_TO_REMEMBER];
+    uint16_t tick[LED_HITS_TO_REMEMBER];
+} last_hit_t;
+
+extern last_hit_t g_last_hit_tracker;
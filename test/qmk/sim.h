@@ -0,0 +1,91 @@
+#pragma once
+
+// Control side of the host build: drives the keymap through a virtual clock
+// and exposes what it sent to the host, the LEDs and the other half.
+
+#include "qmk.h"
+#include "transactions.h"
+
+// Virtual milliseconds since boot. Only sim_scan() and wait_ms() advance it
+extern uint32_t sim_now;
+
+// Which half this process plays. Set before sim_boot()
+extern bool sim_master;
+extern bool sim_left;
+
+// Result of every transaction_rpc_send() from now on
+extern bool sim_transactions_ok;
+
+typedef struct {
+    uint32_t events;        // Key events injected
+    uint32_t code_calls;    // register_code/unregister_code, 8 and 16 bit
+    uint32_t mod_calls;     // add/del/set/clear of real or weak mods
+    uint32_t reports;       // Keyboard reports that reached the host
+    uint32_t mouse_reports; // Mouse reports sent
+    uint32_t transactions;  // transaction_rpc_send() calls
+    uint32_t transaction_bytes;
+    uint32_t eeprom_writes; // Bytes actually changed in EEPROM
+    uint32_t chunks;        // RGB render chunks run
+    uint32_t frames;        // RGB frames flushed
+    uint32_t waits;         // wait_ms() calls
+} sim_counters_t;
+
+extern sim_counters_t sim_counters;
+
+typedef struct {
+    uint32_t          time;
+    report_keyboard_t report;
+} sim_keyboard_log_t;
+
+typedef struct {
+    uint32_t       time;
+    report_mouse_t report;
+} sim_mouse_log_t;
+
+// Reports in the order the host got them, since the last sim_clear_output()
+extern sim_keyboard_log_t *sim_keyboard_log;
+extern size_t              sim_keyboard_log_count;
+extern sim_mouse_log_t    *sim_mouse_log;
+extern size_t              sim_mouse_log_count;
+
+// Last raw HID reply
+extern uint8_t sim_raw_hid_reply[32];
+extern uint8_t sim_raw_hid_reply_length;
+
+// Last payload sent per split transaction, for replay on a slave
+extern uint8_t sim_transaction_data[SIM_TRANSACTION_COUNT][32];
+extern uint8_t sim_transaction_length[SIM_TRANSACTION_COUNT];
+
+// LED colors as last flushed to the strip
+extern RGB sim_leds[RGB_MATRIX_LED_COUNT];
+
+// Runs keyboard_post_init_user() and one scan
+void sim_boot(void);
+
+// One main loop pass: an RGB matrix task step, housekeeping, then 1 ms
+void sim_scan(void);
+void sim_run(uint32_t ms);
+
+// A debounced key event, as QMK hands it to process_record()
+void sim_key(uint8_t row, uint8_t col, bool pressed);
+// Counts as input for last_input_activity_elapsed() without a key event
+void sim_input_activity(void);
+
+// Press and release with the given hold time, scanning in between
+void sim_tap(uint8_t row, uint8_t col, uint32_t hold_ms);
+
+// One step of QMK's rgb_matrix_task() state machine
+void sim_rgb_task(void);
+// Steps the RGB task until a whole frame has been rendered and flushed,
+// without waiting out the flush limit or advancing the clock
+void sim_render_frame(void);
+
+// Delivers a payload to the handler this process registered for the
+// transaction, as the slave side of transaction_rpc_send() does
+void sim_transaction_receive(int8_t id, const void *data, uint8_t length);
+
+void sim_clear_output(void);
+
+// The host's view from the last keyboard report
+bool    sim_host_key(uint8_t kc);
+uint8_t sim_host_mods(void);
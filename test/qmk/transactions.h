@@ -0,0 +1,16 @@
+#pragma once
+
+#include "qmk.h"
+
+// Split transaction ids, with the keymap's own from config.h
+enum sim_transaction_ids {
+#ifdef SPLIT_TRANSACTION_IDS_USER
+    SPLIT_TRANSACTION_IDS_USER,
+#endif
+    SIM_TRANSACTION_COUNT
+};
+
+typedef void (*slave_callback_t)(uint8_t in_buflen, const void *in_data, uint8_t out_buflen, void *out_data);
+
+void transaction_register_rpc(int8_t transaction_id, slave_callback_t callback);
+bool transaction_rpc_send(int8_t transaction_id, uint8_t initiator2target_buffer_size, const void *initiator2target_buffer);
@@ -0,0 +1,48 @@
+// Replays key traces through the keymap and prints what the host would get.
+//
+//     sim [--right] [--frame] [--tail ms] trace...
+//
+// --right plays the right half as master, --frame also prints the LED frame
+// the half last flushed, --tail scans this long after the last event
+// (default 500 ms).
+
+#include "trace.h"
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char **argv) {
+    bool     frame = false;
+    uint32_t tail  = 500;
+    int      first = 1;
+    for (; first < argc && argv[first][0] == '-'; first++) {
+        if (strcmp(argv[first], "--right") == 0) {
+            sim_left = false;
+        } else if (strcmp(argv[first], "--frame") == 0) {
+            frame = true;
+        } else if (strcmp(argv[first], "--tail") == 0 && first + 1 < argc) {
+            tail = strtoul(argv[++first], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--right] [--frame] [--tail ms] trace...\n", argv[0]);
+            return 2;
+        }
+    }
+    if (first == argc) {
+        fprintf(stderr, "usage: %s [--right] [--frame] [--tail ms] trace...\n", argv[0]);
+        return 2;
+    }
+
+    sim_boot();
+    for (int i = first; i < argc; i++) {
+        trace_t trace;
+        if (!trace_load(argv[i], &trace)) return 1;
+        trace_replay(&trace, tail);
+        trace_free(&trace);
+    }
+
+    trace_print_reports(stdout);
+    if (frame) {
+        sim_render_frame();
+        trace_print_frame(stdout);
+    }
+    return 0;
+}
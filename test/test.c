@@ -0,0 +1,109 @@
+#include "test.h"
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#ifndef GOLDEN_DIR
+#    define GOLDEN_DIR "golden"
+#endif
+
+void test_fail(const char *file, int line, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "%s:%d: check failed at %u ms: ", file, line, (unsigned)sim_now);
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+    va_end(args);
+    exit(1);
+}
+
+static char *read_file(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *text = malloc(size + 1);
+    text[fread(text, 1, size, file)] = '\0';
+    fclose(file);
+    return text;
+}
+
+void test_golden(const char *name, const char *text) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", GOLDEN_DIR, name);
+
+    const char *update = getenv("UPDATE_GOLDEN");
+    if (update && strcmp(update, "0") != 0) {
+        FILE *file = fopen(path, "wb");
+        if (!file) test_fail(__FILE__, __LINE__, "can't write %s", path);
+        fputs(text, file);
+        fclose(file);
+        return;
+    }
+
+    char *golden = read_file(path);
+    if (!golden) test_fail(__FILE__, __LINE__, "missing %s, run with UPDATE_GOLDEN=1", path);
+    if (strcmp(golden, text) != 0) {
+        // Point at the first differing line
+        int         line = 1;
+        const char *a = golden, *b = text;
+        while (*a && *a == *b) {
+            if (*a == '\n') line++;
+            a++;
+            b++;
+        }
+        test_fail(__FILE__, __LINE__, "output differs from %s at line %d", path, line);
+    }
+    free(golden);
+}
+
+double test_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static bool selected(int argc, char **argv, const char *name) {
+    bool any = false;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] == '-') continue;
+        any = true;
+        if (strcmp(argv[i], name) == 0) return true;
+    }
+    return !any;
+}
+
+static bool run_case(const test_case_t *test) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        test->fn();
+        fflush(stdout);
+        exit(0);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int test_main(int argc, char **argv, const test_case_t *tests, size_t test_count, const test_case_t *benches, size_t bench_count) {
+    bool bench = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0) bench = true;
+    }
+    const test_case_t *cases = bench ? benches : tests;
+    size_t             count = bench ? bench_count : test_count;
+
+    int failed = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!selected(argc, argv, cases[i].name)) continue;
+        bool ok = run_case(&cases[i]);
+        if (!bench || !ok) printf("%s %s\n", ok ? "PASS" : "FAIL", cases[i].name);
+        if (!ok) failed++;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+// Minimal runner for the host tests. Every test and benchmark runs in its own
+// process, since the keymap keeps its state in file-scope statics.
+
+#include "sim.h"
+#include <stdio.h>
+
+typedef struct {
+    const char *name;
+    void (*fn)(void);
+} test_case_t;
+
+#define TEST_CASE(fn) {#fn, fn}
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) test_fail(__FILE__, __LINE__, "%s", #cond);        \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                                              \
+    do {                                                                                            \
+        long long a_ = (long long)(a), b_ = (long long)(b);                                         \
+        if (a_ != b_) test_fail(__FILE__, __LINE__, "%s == %s (%lld != %lld)", #a, #b, a_, b_);     \
+    } while (0)
+
+void test_fail(const char *file, int line, const char *format, ...) __attribute__((noreturn, format(printf, 3, 4)));
+
+// Compares text with golden/<name>. With UPDATE_GOLDEN=1 in the environment
+// the golden file is rewritten instead.
+void test_golden(const char *name, const char *text);
+
+// Monotonic wall clock, for benchmarks
+double test_seconds(void);
+
+// Runs the tests, or the benchmarks with --bench. Further arguments select
+// cases by name.
+int test_main(int argc, char **argv, const test_case_t *tests, size_t test_count, const test_case_t *benches, size_t bench_count);
+
+#define TEST_MAIN(tests, benches)                                                                 \
+    int main(int argc, char **argv) {                                                             \
+        return test_main(argc, argv, tests, sizeof(tests) / sizeof(tests[0]), benches,            \
+                         sizeof(benches) / sizeof(benches[0]));                                   \
+    }
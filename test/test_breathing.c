@@ -0,0 +1,91 @@
+// Integer breathing against the float sin() curve it replaced.
+
+#include "test.h"
+#include "breathing.h"
+#include <math.h>
+#include <stdlib.h>
+
+// The old keymap's breathing_brightness(), at a given phase
+static uint8_t float_brightness(uint8_t base_val, uint8_t phase) {
+    float breathing = (sin((phase / 255.0) * 2 * 3.14159) + 1.0) / 2.0;
+    return (uint8_t)(base_val * breathing);
+}
+
+static void sine_within_1_lsb_of_float_curve(void) {
+    for (int base = 0; base < 256; base++) {
+        for (int phase = 0; phase < 256; phase++) {
+            int level = breathing_scale(base, breathing_wave_level(wave_sine, phase));
+            int error = abs(level - float_brightness(base, phase));
+            if (error > 1) test_fail(__FILE__, __LINE__, "base %d phase %d: %d, float %d", base, phase, level, float_brightness(base, phase));
+        }
+    }
+}
+
+// The old curve's phase was (timer / 3) & 0xFF. Updates at uneven intervals
+// and across the 16-bit timer wrap must land on the same phase.
+static void phase_follows_old_period(void) {
+    uint32_t rng = 12345;
+    breathing_update();
+    while (sim_now < 200000) {
+        rng = rng * 1103515245 + 12345;
+        sim_now += 1 + (rng >> 16) % 9;
+        breathing_update();
+        uint8_t phase = (sim_now / 3) & 0xFF;
+        CHECK_EQ(breathing_level(0), breathing_wave_level(wave_sine, phase));
+    }
+}
+
+static void update_reports_phase_changes_only(void) {
+    CHECK(breathing_update());
+    CHECK(!breathing_update());
+    sim_now += 2;
+    CHECK(!breathing_update());
+    sim_now += 1;
+    CHECK(breathing_update());
+}
+
+static void waves_span_full_range(void) {
+    static const breathing_wave waves[] = {wave_sine, wave_triangle, wave_eased};
+    for (uint8_t w = 0; w < 3; w++) {
+        uint8_t lo = 255, hi = 0;
+        for (int phase = 0; phase < 256; phase++) {
+            uint8_t level = breathing_wave_level(waves[w], phase);
+            if (level < lo) lo = level;
+            if (level > hi) hi = level;
+        }
+        CHECK(lo <= 1);
+        CHECK(hi >= 254);
+        CHECK(breathing_wave_level(waves[w], 64) >= 254);
+    }
+}
+
+#define BENCH_EVALS 20000000
+
+static void bench_levels(void) {
+    volatile uint8_t sink  = 0;
+    double           start = test_seconds();
+    for (uint32_t n = 0; n < BENCH_EVALS; n++) {
+        sink += breathing_scale(n >> 8, breathing_wave_level(wave_sine, n));
+    }
+    double integer = test_seconds() - start;
+    start          = test_seconds();
+    for (uint32_t n = 0; n < BENCH_EVALS; n++) {
+        sink += float_brightness(n >> 8, n);
+    }
+    double floating = test_seconds() - start;
+    printf("sine level: integer %.1f ns, float sin() %.1f ns per evaluation\n", integer / BENCH_EVALS * 1e9,
+           floating / BENCH_EVALS * 1e9);
+}
+
+static const test_case_t tests[] = {
+    TEST_CASE(sine_within_1_lsb_of_float_curve),
+    TEST_CASE(phase_follows_old_period),
+    TEST_CASE(update_reports_phase_changes_only),
+    TEST_CASE(waves_span_full_range),
+};
+
+static const test_case_t benches[] = {
+    TEST_CASE(bench_levels),
+};
+
+TEST_MAIN(tests, benches)
@@ -0,0 +1,163 @@
+// The chord engine through the keymap: the MO(1)+MO(2) layer 3 chord, the
+// keys it holds back and replays, and its per-event cost.
+
+#include "test.h"
+#include "chord.h"
+
+// Matrix positions; right-half columns are mirrored
+#define K_A 1, 1
+#define K_L1_ARROW_R 1, 5
+#define K_MO1 3, 4
+#define K_MO2 7, 4
+#define K_L4_MO5 3, 4
+
+static bool log_has(uint8_t key) {
+    for (size_t i = 0; i < sim_keyboard_log_count; i++) {
+        for (uint8_t k = 0; k < KEYBOARD_REPORT_KEYS; k++) {
+            if (sim_keyboard_log[i].report.keys[k] == key) return true;
+        }
+    }
+    return false;
+}
+
+static void boot(void) {
+    sim_boot();
+    sim_run(100);
+    sim_clear_output();
+}
+
+static void thumbs_in_either_order_hold_layer3(void) {
+    boot();
+    sim_key(K_MO2, true);
+    sim_run(20);
+    sim_key(K_MO1, true);
+    CHECK(layer_state_is(3));
+    sim_key(K_MO1, false);
+    CHECK(layer_state_is(0));
+    sim_key(K_MO2, false);
+    sim_run(10);
+    CHECK(layer_state_is(0));
+    CHECK_EQ(sim_keyboard_log_count, 0);
+}
+
+static void member_press_waits_out_timeout(void) {
+    boot();
+    sim_key(K_MO1, true);
+    sim_run(20);
+    CHECK(layer_state_is(0));
+    sim_run(20);
+    CHECK(layer_state_is(1));
+    // Too late for the chord, so the stacked MO(3) on layer 1 takes over
+    sim_key(K_MO2, true);
+    CHECK(layer_state_is(3));
+    sim_key(K_MO2, false);
+    sim_key(K_MO1, false);
+    CHECK(layer_state_is(0));
+}
+
+static void non_member_passes_straight_through(void) {
+    boot();
+    sim_key(K_A, true);
+    CHECK_EQ(sim_keyboard_log_count, 1);
+    sim_key(K_A, false);
+    CHECK_EQ(sim_keyboard_log_count, 2);
+}
+
+// Regression: a key pressed within the timeout of MO(1) resolved on layer 0
+// (G) while its action ran on layer 1, so ARROW_R did nothing
+static void key_within_timeout_resolves_on_replayed_layer(void) {
+    boot();
+    sim_key(K_MO1, true);
+    sim_run(10);
+    sim_tap(K_L1_ARROW_R, 20);
+    sim_run(100);
+    sim_key(K_MO1, false);
+    CHECK(log_has(KC_MINS));
+    CHECK(log_has(KC_DOT));
+    CHECK(!log_has(KC_G));
+    CHECK(layer_state_is(0));
+}
+
+static void member_release_replays_press(void) {
+    boot();
+    sim_key(K_MO1, true);
+    sim_run(10);
+    sim_key(K_MO1, false);
+    CHECK(layer_state_is(0));
+    sim_tap(K_A, 20);
+    CHECK(log_has(KC_A));
+}
+
+static void gaming_layer_bypasses_chords(void) {
+    boot();
+    layer_move(4);
+    sim_key(K_L4_MO5, true);
+    CHECK(layer_state_is(5));
+    sim_key(K_L4_MO5, false);
+    CHECK(layer_state_is(4));
+}
+
+// ----------------------------------------------------------------------------
+// Benchmarks
+// ----------------------------------------------------------------------------
+
+#define BENCH_EVENTS 2000000
+
+static uint32_t rng_state = 0x6D2B79F5;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// Taps on the letter block, one in thumb_odds of them on a layer thumb.
+// Times process_chord() and chord_task() alone, a millisecond apart, so
+// held back thumbs are replayed by a release or a timeout. Replays go
+// through process_record(), and their cost is included.
+static void bench_chord_events(const char *label, uint32_t thumb_odds) {
+    static const uint8_t rows[] = {0, 1, 2, 4, 5, 6};
+    static keyrecord_t   records[4096];
+    for (int i = 0; i < 4096; i += 2) {
+        uint32_t pick = rng();
+        keypos_t key  = {.col = 1 + pick % 5, .row = rows[pick / 5 % 6]};
+        if (thumb_odds && pick / 30 % thumb_odds == 0) key = (keypos_t){.col = 4, .row = pick & 1 ? 3 : 7};
+        records[i]     = (keyrecord_t){.event = {.key = key, .type = 1, .pressed = true}};
+        records[i + 1] = (keyrecord_t){.event = {.key = key, .type = 1, .pressed = false}};
+    }
+
+    sim_boot();
+    uint32_t consumed = 0;
+    double   start    = test_seconds();
+    for (uint32_t n = 0; n < BENCH_EVENTS; n++) {
+        keyrecord_t record = records[n & 4095];
+        record.event.time  = (uint16_t)(sim_now | 1);
+        consumed += !process_chord(&record);
+        sim_now++;
+        chord_task();
+        if (sim_keyboard_log_count > 4096) sim_clear_output();
+    }
+    double elapsed = test_seconds() - start;
+    printf("%-16s %5.1f ns/event, %.3f held back/event\n", label, elapsed / BENCH_EVENTS * 1e9, (double)consumed / BENCH_EVENTS);
+}
+
+static void bench_chord(void) {
+    bench_chord_events("letters", 0);
+    bench_chord_events("1 in 8 thumbs", 8);
+}
+
+static const test_case_t tests[] = {
+    TEST_CASE(thumbs_in_either_order_hold_layer3),
+    TEST_CASE(member_press_waits_out_timeout),
+    TEST_CASE(non_member_passes_straight_through),
+    TEST_CASE(key_within_timeout_resolves_on_replayed_layer),
+    TEST_CASE(member_release_replays_press),
+    TEST_CASE(gaming_layer_bypasses_chords),
+};
+
+static const test_case_t benches[] = {
+    TEST_CASE(bench_chord),
+};
+
+TEST_MAIN(tests, benches)
@@ -0,0 +1,196 @@
+// Per-key debounce against synthetic bounce waveforms: one key pressed over
+// and over with contact bounce after each edge and optional one-scan
+// glitches while it is up, scanned every millisecond. Measures how late each
+// edge is reported and how many extra presses get through.
+
+#include "test.h"
+#include "debounce.h"
+#include "per_key_debounce.h"
+#include <stdlib.h>
+
+#ifndef DEBOUNCE
+#    define DEBOUNCE 5
+#endif
+
+#define KEY_ROW 1
+#define KEY_COL 3
+
+typedef struct {
+    uint8_t  bounce_min, bounce_max;  // ms of random contact after each edge
+    uint16_t glitch_per_mille;        // Share of idle gaps with a 1 ms spike
+} noise_t;
+
+typedef struct {
+    uint32_t press, release;  // ms of the first contact and the first break
+} keypress_t;
+
+typedef struct {
+    uint32_t presses, missed, false_presses;
+    uint64_t press_latency, release_latency;
+    uint32_t press_max, release_max;
+} debounce_stats_t;
+
+static uint32_t rng_state = 0x1B873593;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static uint32_t bounce(bool *raw, uint32_t t, bool settled, const noise_t *noise) {
+    uint32_t length = noise->bounce_min + rng() % (noise->bounce_max - noise->bounce_min + 1);
+    raw[t++]        = settled;
+    for (uint32_t i = 1; i < length; i++) raw[t++] = rng() & 1;
+    return t;
+}
+
+// Fills raw with count keypresses: a 30-200 ms gap, the press with its
+// bounce, a 30-120 ms hold, and the release with its bounce. Returns the
+// length in ms.
+static uint32_t generate(bool *raw, keypress_t *presses, uint32_t count, const noise_t *noise) {
+    uint32_t t = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t gap = 30 + rng() % 171;
+        for (uint32_t g = 0; g < gap; g++) raw[t + g] = false;
+        if (rng() % 1000 < noise->glitch_per_mille) raw[t + 10 + rng() % (gap - 20)] = true;
+        t += gap;
+
+        presses[i].press = t;
+        t                = bounce(raw, t, true, noise);
+        uint32_t hold    = 30 + rng() % 91;
+        for (uint32_t h = 0; h < hold; h++) raw[t++] = true;
+        presses[i].release = t;
+        t                  = bounce(raw, t, false, noise);
+    }
+    for (uint32_t g = 0; g < 200; g++) raw[t++] = false;
+    return t;
+}
+
+#define MAX_KEYPRESS_MS (200 + 2 * 255 + 120)
+
+// Scans raw through debounce() on the given layer and scores the cooked
+// edges against the presses
+static debounce_stats_t simulate(uint8_t layer, uint32_t count, const noise_t *noise) {
+    bool       *raw     = malloc((count + 1) * MAX_KEYPRESS_MS);
+    bool       *cooked  = malloc((count + 1) * MAX_KEYPRESS_MS);
+    keypress_t *presses = malloc(count * sizeof(*presses));
+    uint32_t    length  = generate(raw, presses, count, noise);
+
+    sim_boot();
+    layer_move(layer);
+    debounce_init(MATRIX_ROWS);
+    matrix_row_t raw_rows[MATRIX_ROWS] = {0}, cooked_rows[MATRIX_ROWS] = {0};
+    for (uint32_t t = 0; t < length; t++) {
+        matrix_row_t row = raw[t] ? 1 << KEY_COL : 0;
+        bool         changed = raw_rows[KEY_ROW] != row;
+        raw_rows[KEY_ROW]    = row;
+        debounce(raw_rows, cooked_rows, MATRIX_ROWS, changed);
+        cooked[t] = cooked_rows[KEY_ROW] & (1 << KEY_COL);
+        sim_now++;
+    }
+
+    // Each press owns the cooked edges from its first contact up to the
+    // next press's
+    debounce_stats_t stats = {.presses = count};
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t end = i + 1 < count ? presses[i + 1].press : length;
+        uint32_t rises = 0, rise = 0, fall = 0;
+        for (uint32_t t = presses[i].press; t < end; t++) {
+            bool before = t && cooked[t - 1];
+            if (cooked[t] && !before && rises++ == 0) rise = t;
+            if (!cooked[t] && before && !fall && t >= presses[i].release) fall = t;
+        }
+        if (!rises || rise >= presses[i].release) {
+            stats.missed++;
+            continue;
+        }
+        stats.false_presses += rises - 1;
+        uint32_t press_latency = rise - presses[i].press, release_latency = fall - presses[i].release;
+        stats.press_latency += press_latency;
+        stats.release_latency += release_latency;
+        if (press_latency > stats.press_max) stats.press_max = press_latency;
+        if (release_latency > stats.release_max) stats.release_max = release_latency;
+    }
+    free(raw);
+    free(cooked);
+    free(presses);
+    return stats;
+}
+
+// Layer 0 types with symmetric debounce, layer 4 games with eager
+#define LAYER_SYMMETRIC 0
+#define LAYER_EAGER 4
+
+static const noise_t short_bounce = {1, DEBOUNCE - 1, 0};
+
+static void short_bounce_gives_one_edge_each_way(void) {
+    for (uint8_t layer = 0; layer <= LAYER_EAGER; layer += LAYER_EAGER) {
+        debounce_stats_t stats = simulate(layer, 2000, &short_bounce);
+        CHECK_EQ(stats.missed, 0);
+        CHECK_EQ(stats.false_presses, 0);
+    }
+}
+
+static void eager_press_is_reported_on_first_scan(void) {
+    debounce_stats_t eager = simulate(LAYER_EAGER, 2000, &short_bounce);
+    CHECK_EQ(eager.press_max, 0);
+    debounce_stats_t symmetric = simulate(LAYER_SYMMETRIC, 2000, &short_bounce);
+    CHECK(symmetric.press_latency >= (uint64_t)DEBOUNCE * symmetric.presses);
+}
+
+static void symmetric_filters_glitches(void) {
+    static const noise_t glitches = {1, DEBOUNCE - 1, 1000};
+    debounce_stats_t     stats    = simulate(LAYER_SYMMETRIC, 2000, &glitches);
+    CHECK_EQ(stats.false_presses, 0);
+}
+
+static void releases_wait_in_both_modes(void) {
+    for (uint8_t layer = 0; layer <= LAYER_EAGER; layer += LAYER_EAGER) {
+        debounce_stats_t stats = simulate(layer, 2000, &short_bounce);
+        CHECK(stats.release_latency >= (uint64_t)DEBOUNCE * stats.presses);
+        CHECK(stats.release_max < 2 * DEBOUNCE);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Benchmarks
+// ----------------------------------------------------------------------------
+
+static void print_stats(const char *mode, const char *noise, const debounce_stats_t *stats) {
+    uint32_t reported = stats->presses - stats->missed;
+    printf("%-9s %-26s press %4.1f ms mean, %2u max; release %4.1f ms mean, %2u max; %.4f false presses/press, %u missed\n", mode,
+           noise, (double)stats->press_latency / reported, stats->press_max, (double)stats->release_latency / reported,
+           stats->release_max, (double)stats->false_presses / stats->presses, stats->missed);
+}
+
+static void bench_bounce(void) {
+    static const struct {
+        const char *name;
+        noise_t     noise;
+    } profiles[] = {
+        {"clean, 1-3 ms bounce", {1, 3, 0}},
+        {"worn, 1-10 ms bounce", {1, 10, 0}},
+        {"noisy, 20% idle glitches", {1, 3, 200}},
+    };
+    for (uint8_t p = 0; p < sizeof(profiles) / sizeof(profiles[0]); p++) {
+        debounce_stats_t symmetric = simulate(LAYER_SYMMETRIC, 100000, &profiles[p].noise);
+        debounce_stats_t eager     = simulate(LAYER_EAGER, 100000, &profiles[p].noise);
+        print_stats("symmetric", profiles[p].name, &symmetric);
+        print_stats("eager", profiles[p].name, &eager);
+    }
+}
+
+static const test_case_t tests[] = {
+    TEST_CASE(short_bounce_gives_one_edge_each_way),
+    TEST_CASE(eager_press_is_reported_on_first_scan),
+    TEST_CASE(symmetric_filters_glitches),
+    TEST_CASE(releases_wait_in_both_modes),
+};
+
+static const test_case_t benches[] = {
+    TEST_CASE(bench_bounce),
+};
+
+TEST_MAIN(tests, benches)
@@ -0,0 +1,469 @@
+// The usage heatmap with HEATMAP_ENABLE: saturating counters, the two
+// EEPROM slots across power cycles, the levels synced to the slave, the raw
+// HID dump, and the layer 3 frames drawn from a non-uniform map.
+
+#include "test.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Matrix positions on layer 0; right-half columns are mirrored
+#define K_A 1, 1
+#define K_GAME_W 1, 2
+
+#ifdef HEATMAP_ENABLE
+
+#    include "eeconfig.h"
+#    include "heatmap.h"
+
+// As in heatmap.c: a slot is a sequence byte, a checksum over the sequence
+// and the counters from CHECKSUM_SEED, then the counters
+#    define CHECKSUM_SEED 0xA5
+#    define SLOT_SIZE (2 + sizeof(heatmap_t))
+#    define SLOT_ADDR(slot) (EECONFIG_USER_DATABLOCK + (slot) * SLOT_SIZE)
+
+#    define KEY_INDEX(row, col) ((row) * MATRIX_COLS + (col))
+
+static void boot(void) {
+    sim_boot();
+    sim_run(100);
+}
+
+static void record(uint8_t layer, uint8_t row, uint8_t col, uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) heatmap_record(layer, row, col);
+}
+
+static const uint8_t *hid(uint8_t command, uint16_t offset) {
+    uint8_t data[32] = {command, offset & 0xFF, offset >> 8};
+    raw_hid_receive(data, sizeof(data));
+    CHECK_EQ(sim_raw_hid_reply_length, 32);
+    CHECK_EQ(sim_raw_hid_reply[0], command);
+    return sim_raw_hid_reply;
+}
+
+// Reads the counters back the way the host does, 28 bytes at a time
+static void dump(heatmap_t *out) {
+    for (uint16_t offset = 0; offset < sizeof(*out); offset += 28) {
+        const uint8_t *reply = hid(HEATMAP_CMD_READ, offset);
+        uint8_t        count = sizeof(*out) - offset < 28 ? sizeof(*out) - offset : 28;
+        CHECK_EQ(reply[3], count);
+        memcpy((uint8_t *)out + offset, &reply[4], count);
+    }
+}
+
+// Flushes now and lets the flush run to the end
+static void flush(void) {
+    hid(HEATMAP_CMD_FLUSH, 0);
+    sim_run(SLOT_SIZE);
+}
+
+// A layer 0 map with a busy home row and a cold top row, and a few layer 1
+// and 2 keys
+static void record_pattern(void) {
+    static const uint8_t rows[] = {0, 1, 2, 4, 5, 6};
+    for (uint8_t r = 0; r < 6; r++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            uint8_t row = rows[r];
+            record(0, row, col, (row % 4 == 1 ? 60 : row % 4 == 0 ? 4 : 20) + col * 5);
+        }
+    }
+    record(1, 0, 2, 9);
+    record(2, 5, 3, 3);
+}
+
+static void write_slot(uint8_t slot, uint8_t sequence, const heatmap_t *counters) {
+    uint8_t sum = CHECKSUM_SEED + sequence;
+    for (size_t i = 0; i < sizeof(*counters); i++) sum += ((const uint8_t *)counters)[i];
+    SLOT_ADDR(slot)[0] = sequence;
+    SLOT_ADDR(slot)[1] = sum;
+    memcpy(SLOT_ADDR(slot) + 2, counters, sizeof(*counters));
+}
+
+// Runs a phase of the keyboard's life in a child process from the current
+// EEPROM, and takes its EEPROM back as if the power went at the end. The
+// keymap's statics here stay untouched, as after a real power cycle.
+static void power_cycle(void (*phase)(void)) {
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        phase();
+        CHECK(write(fds[1], sim_eeprom, sizeof(sim_eeprom)) == sizeof(sim_eeprom));
+        _exit(0);
+    }
+    close(fds[1]);
+    size_t got = 0;
+    while (got < sizeof(sim_eeprom)) {
+        ssize_t n = read(fds[0], sim_eeprom + got, sizeof(sim_eeprom) - got);
+        if (n <= 0) break;
+        got += n;
+    }
+    close(fds[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    CHECK_EQ(got, sizeof(sim_eeprom));
+}
+
+// ----------------------------------------------------------------------------
+// Counters
+// ----------------------------------------------------------------------------
+
+static void counter_halves_its_table_at_255(void) {
+    boot();
+    record(0, 1, 2, 100);
+    record(0, 1, 3, 254);
+    record(1, 1, 2, 7);
+    heatmap_t map;
+    dump(&map);
+    CHECK_EQ(map.keys[0][KEY_INDEX(1, 2)], 100);
+    CHECK_EQ(map.keys[0][KEY_INDEX(1, 3)], 254);
+    CHECK_EQ(heatmap_level(0, 1, 3), 255);
+
+    // The 255th press halves the whole layer, and only that layer
+    heatmap_record(0, 1, 3);
+    dump(&map);
+    CHECK_EQ(map.keys[0][KEY_INDEX(1, 3)], 127);
+    CHECK_EQ(map.keys[0][KEY_INDEX(1, 2)], 50);
+    CHECK_EQ(map.keys[1][KEY_INDEX(1, 2)], 7);
+    CHECK_EQ(heatmap_level(0, 1, 3), 255);
+    CHECK_EQ(heatmap_level(0, 1, 2), 50 * 255 / 127);
+}
+
+static void bigram_halves_its_table_at_255(void) {
+    boot();
+    // 1-2 alternating: 100 presses of each give 1->2 100 times and 2->1 99
+    for (uint8_t i = 0; i < 100; i++) {
+        heatmap_record(0, 0, 1);
+        heatmap_record(0, 0, 2);
+    }
+    heatmap_t map;
+    dump(&map);
+    uint8_t forth = HEATMAP_BIGRAM_HASH(KEY_INDEX(0, 1), KEY_INDEX(0, 2));
+    uint8_t back  = HEATMAP_BIGRAM_HASH(KEY_INDEX(0, 2), KEY_INDEX(0, 1));
+    CHECK_EQ(map.bigrams[forth], 100);
+    CHECK_EQ(map.bigrams[back], 99);
+
+    // 3-3 repeated takes its bucket to 255, halving every bucket
+    uint8_t repeat = HEATMAP_BIGRAM_HASH(KEY_INDEX(0, 3), KEY_INDEX(0, 3));
+    record(0, 0, 3, 256);
+    dump(&map);
+    CHECK_EQ(map.bigrams[repeat], 127);
+    CHECK_EQ(map.bigrams[forth], 50);
+    CHECK_EQ(map.bigrams[back], 49);
+}
+
+// Presses are counted on the typing layers through the keymap, and not on
+// the gaming layers
+static void keymap_counts_typing_layers_only(void) {
+    boot();
+    sim_tap(K_A, 20);
+    sim_tap(K_A, 20);
+    layer_move(4);
+    sim_run(50);
+    sim_tap(K_GAME_W, 20);
+    heatmap_t map;
+    dump(&map);
+    CHECK_EQ(map.keys[0][KEY_INDEX(1, 1)], 2);
+    uint32_t total = 0;
+    for (uint8_t layer = 0; layer < HEATMAP_LAYERS; layer++) {
+        for (uint8_t key = 0; key < HEATMAP_KEYS; key++) total += map.keys[layer][key];
+    }
+    CHECK_EQ(total, 2);
+}
+
+// ----------------------------------------------------------------------------
+// Raw HID
+// ----------------------------------------------------------------------------
+
+static void hid_dump_reset_and_flush(void) {
+    boot();
+    record_pattern();
+
+    // READ: offset in, byte count and bytes out, clipped at the end
+    heatmap_t map;
+    dump(&map);
+    const uint8_t *reply = hid(HEATMAP_CMD_READ, 1);
+    CHECK_EQ(reply[3], 28);
+    CHECK(memcmp(&reply[4], (uint8_t *)&map + 1, 28) == 0);
+    CHECK_EQ(map.keys[0][KEY_INDEX(1, 5)], 60 + 25);
+    CHECK_EQ(map.keys[1][KEY_INDEX(0, 2)], 9);
+    reply = hid(HEATMAP_CMD_READ, sizeof(heatmap_t) - 10);
+    CHECK_EQ(reply[3], 10);
+    reply = hid(HEATMAP_CMD_READ, sizeof(heatmap_t));
+    CHECK_EQ(reply[3], 0);
+
+    // FLUSH: writes the counters to a slot over the next passes
+    uint32_t writes = sim_counters.eeprom_writes;
+    hid(HEATMAP_CMD_FLUSH, 0);
+    CHECK_EQ(sim_counters.eeprom_writes, writes);
+    sim_run(SLOT_SIZE);
+    CHECK(sim_counters.eeprom_writes > writes);
+    CHECK(memcmp(SLOT_ADDR(0) + 2, &map, sizeof(map)) == 0);
+
+    // RESET: clears every counter in RAM, not the slots
+    hid(HEATMAP_CMD_RESET, 0);
+    dump(&map);
+    for (size_t i = 0; i < sizeof(map); i++) CHECK_EQ(((uint8_t *)&map)[i], 0);
+    CHECK_EQ(heatmap_level(0, 1, 5), 0);
+    CHECK_EQ(SLOT_ADDR(0)[2 + KEY_INDEX(1, 5)], 60 + 25);
+}
+
+// ----------------------------------------------------------------------------
+// Slots
+// ----------------------------------------------------------------------------
+
+static heatmap_t map_with(uint8_t layer, uint8_t key, uint8_t count) {
+    heatmap_t map = {0};
+    map.keys[layer][key] = count;
+    return map;
+}
+
+static uint8_t loaded_count(uint8_t layer, uint8_t key) {
+    heatmap_t map;
+    dump(&map);
+    return map.keys[layer][key];
+}
+
+static void fresh_eeprom_loads_nothing(void) {
+    memset(sim_eeprom, 0xFF, sizeof(sim_eeprom));
+    boot();
+    CHECK_EQ(loaded_count(0, 0), 0);
+    CHECK_EQ(heatmap_level(0, 0, 0), 0);
+}
+
+static void newest_valid_slot_is_loaded(void) {
+    heatmap_t older = map_with(0, 7, 11), newer = map_with(0, 7, 22);
+    write_slot(0, 5, &older);
+    write_slot(1, 6, &newer);
+    boot();
+    CHECK_EQ(loaded_count(0, 7), 22);
+
+    // Sequences wrap: 0 follows 255
+    write_slot(0, 0, &newer);
+    write_slot(1, 255, &older);
+    boot();
+    CHECK_EQ(loaded_count(0, 7), 22);
+}
+
+static void corrupted_slot_falls_back_to_other(void) {
+    heatmap_t older = map_with(0, 7, 11), newer = map_with(0, 7, 22);
+    write_slot(0, 5, &older);
+    write_slot(1, 6, &newer);
+    SLOT_ADDR(1)[2 + 30] ^= 0x10;
+    boot();
+    CHECK_EQ(loaded_count(0, 7), 11);
+
+    // A bad checksum byte alone is enough
+    write_slot(1, 6, &newer);
+    SLOT_ADDR(1)[1] ^= 0x01;
+    boot();
+    CHECK_EQ(loaded_count(0, 7), 11);
+}
+
+// A slot with its counters half overwritten and the header of what was
+// there before, as a flush leaves it when the power goes
+static void torn_slot_falls_back_to_other(void) {
+    heatmap_t older = map_with(0, 7, 11), newer = map_with(0, 7, 22), partial = map_with(0, 7, 33);
+    write_slot(0, 5, &older);
+    write_slot(1, 6, &newer);
+    memcpy(SLOT_ADDR(0) + 2, &partial, sizeof(partial) / 2);
+    boot();
+    CHECK_EQ(loaded_count(0, 7), 22);
+}
+
+// ----------------------------------------------------------------------------
+// Power cycles
+// ----------------------------------------------------------------------------
+
+static void phase_count_and_flush(void) {
+    boot();
+    record_pattern();
+    flush();
+}
+
+static void phase_add_and_flush(void) {
+    boot();
+    record(0, 2, 2, 50);
+    flush();
+}
+
+// Power goes a quarter of the way through the flush
+static void phase_add_and_lose_power_mid_flush(void) {
+    boot();
+    record(0, 2, 2, 100);
+    hid(HEATMAP_CMD_FLUSH, 0);
+    sim_run(SLOT_SIZE / 16);
+}
+
+static void counts_survive_power_cycle(void) {
+    memset(sim_eeprom, 0, sizeof(sim_eeprom));
+    power_cycle(phase_count_and_flush);
+    boot();
+    CHECK_EQ(loaded_count(0, KEY_INDEX(1, 5)), 60 + 25);
+    CHECK_EQ(loaded_count(0, KEY_INDEX(0, 0)), 4);
+    CHECK_EQ(loaded_count(1, KEY_INDEX(0, 2)), 9);
+}
+
+// The torn slot is the older one, so the boot after it loads the newer one
+// and the next flush writes over the torn slot again
+static void interrupted_flush_resumes_after_boot(void) {
+    memset(sim_eeprom, 0, sizeof(sim_eeprom));
+    power_cycle(phase_count_and_flush);
+    power_cycle(phase_add_and_flush);
+    uint8_t before = SLOT_ADDR(1)[0];
+    power_cycle(phase_add_and_lose_power_mid_flush);
+    CHECK_EQ(SLOT_ADDR(1)[0], before);
+
+    boot();
+    CHECK_EQ(loaded_count(0, KEY_INDEX(2, 2)), 20 + 10 + 50);
+    record(0, 2, 2, 5);
+    flush();
+    CHECK_EQ(SLOT_ADDR(0)[0], (uint8_t)(before + 1));
+    boot();
+    CHECK_EQ(loaded_count(0, KEY_INDEX(2, 2)), 20 + 10 + 50 + 5);
+}
+
+// ----------------------------------------------------------------------------
+// Slave sync and frames
+// ----------------------------------------------------------------------------
+
+static void print_half(FILE *out) {
+    uint8_t first = sim_left ? 0 : RGB_MATRIX_LED_COUNT / 2;
+    for (uint8_t i = first; i < first + RGB_MATRIX_LED_COUNT / 2; i++) {
+        fprintf(out, "led %2u %3u %3u %3u\n", i, sim_leds[i].r, sim_leds[i].g, sim_leds[i].b);
+    }
+}
+
+static void golden_half(const char *half) {
+    char  *text;
+    size_t size;
+    FILE  *out = open_memstream(&text, &size);
+    print_half(out);
+    fclose(out);
+
+    char name[64];
+#    ifdef RGB_GOVERNOR_BUDGET_MA
+    snprintf(name, sizeof(name), "heatmap/%umA/layer3_%s.txt", RGB_GOVERNOR_BUDGET_MA, half);
+#    else
+    snprintf(name, sizeof(name), "heatmap/layer3_%s.txt", half);
+#    endif
+    test_golden(name, text);
+    free(text);
+}
+
+// The master sends the layer 0 levels at 4 bits per key when layer 3 comes
+// up, and the slave draws the right half from them
+static void slave_draws_synced_levels(void) {
+    boot();
+    record_pattern();
+    uint8_t levels[MATRIX_ROWS][MATRIX_COLS];
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) levels[row][col] = heatmap_level(0, row, col);
+    }
+    layer_move(3);
+    sim_run(300);
+    sim_render_frame();
+    golden_half("left");
+
+    uint8_t length = sim_transaction_length[USER_SYNC_HEATMAP];
+    uint8_t payload[32];
+    CHECK_EQ(length, 1 + (HEATMAP_KEYS + 1) / 2);
+    memcpy(payload, sim_transaction_data[USER_SYNC_HEATMAP], length);
+    CHECK_EQ(payload[0], 0);
+
+    sim_master = false;
+    sim_left   = false;
+    boot();
+    layer_move(3);
+    sim_run(300);
+    uint8_t generation = heatmap_generation();
+    sim_transaction_receive(USER_SYNC_HEATMAP, payload, length);
+    CHECK(heatmap_generation() != generation);
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            CHECK_EQ(heatmap_level(0, row, col), (levels[row][col] >> 4) * 17);
+        }
+    }
+    // Other layers show nothing until their levels are sent
+    CHECK_EQ(heatmap_level(1, 0, 2), 0);
+
+    // The new levels rebuild the layer 3 frame
+    sim_run(300);
+    sim_render_frame();
+    golden_half("right");
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+// Benchmarks
+// ----------------------------------------------------------------------------
+
+#define BENCH_EVENTS 500000
+#define BENCH_RUNS 15
+
+// process_record_user() alone on layer 0 letters, best of BENCH_RUNS runs.
+// The "heatmap" variant only differs from "default" by the heatmap, so the
+// two lines compare it on and off.
+static void bench_record_path(void) {
+    static const uint8_t rows[] = {0, 1, 2, 4, 5, 6};
+    static keyrecord_t   records[60];
+    static uint16_t      keycodes[60];
+    uint8_t              count = 0;
+    for (uint8_t r = 0; r < 6; r++) {
+        for (uint8_t col = 1; col <= 5; col++) {
+            keypos_t key        = {.col = col, .row = rows[r]};
+            records[count]      = (keyrecord_t){.event = {.key = key, .type = 1, .pressed = true}};
+            records[count + 1]  = (keyrecord_t){.event = {.key = key, .type = 1, .pressed = false}};
+            keycodes[count]     = keymaps[0][rows[r]][col];
+            keycodes[count + 1] = keycodes[count];
+            count += 2;
+        }
+    }
+
+    sim_boot();
+    double best = 0;
+    for (uint8_t run = 0; run < BENCH_RUNS; run++) {
+        double start = test_seconds();
+        for (uint32_t n = 0; n < BENCH_EVENTS; n++) {
+            keyrecord_t record = records[n % count];
+            process_record_user(keycodes[n % count], &record);
+        }
+        double elapsed = (test_seconds() - start) / BENCH_EVENTS * 1e9;
+        if (!run || elapsed < best) best = elapsed;
+    }
+#ifdef HEATMAP_ENABLE
+    const char *label = "heatmap on";
+#else
+    const char *label = "heatmap off";
+#endif
+    printf("%-12s %5.1f ns/event through process_record_user\n", label, best);
+}
+
+#ifdef HEATMAP_ENABLE
+static const test_case_t tests[] = {
+    TEST_CASE(counter_halves_its_table_at_255),
+    TEST_CASE(bigram_halves_its_table_at_255),
+    TEST_CASE(keymap_counts_typing_layers_only),
+    TEST_CASE(hid_dump_reset_and_flush),
+    TEST_CASE(fresh_eeprom_loads_nothing),
+    TEST_CASE(newest_valid_slot_is_loaded),
+    TEST_CASE(corrupted_slot_falls_back_to_other),
+    TEST_CASE(torn_slot_falls_back_to_other),
+    TEST_CASE(counts_survive_power_cycle),
+    TEST_CASE(interrupted_flush_resumes_after_boot),
+    TEST_CASE(slave_draws_synced_levels),
+};
+#else
+// Nothing to test without the heatmap; the benchmark is its baseline
+static const test_case_t tests[] = {};
+#endif
+
+static const test_case_t benches[] = {
+    TEST_CASE(bench_record_path),
+};
+
+TEST_MAIN(tests, benches)
@@ -0,0 +1,311 @@
+// End-to-end checks of the keymap through the host harness: key events in,
+// HID reports, split transactions and LED frames out.
+
+#include "test.h"
+#include "oneshot.h"
+
+// Matrix positions used below; right-half columns are mirrored
+#define K_A 1, 1
+#define K_R 1, 2
+#define K_L1_EXLM 0, 1
+#define K_L1_ARROW_R 1, 5
+#define K_MO1 3, 4
+#define K_SPC 3, 5
+#define K_OS_SHFT 7, 5
+#define K_MO2 7, 4
+#define K_L2_OS_CTRL 1, 1
+
+#define MOD_LSFT 0x02
+#define MOD_LCTL 0x01
+
+static const report_keyboard_t *report_at(size_t i) {
+    CHECK(i < sim_keyboard_log_count);
+    return &sim_keyboard_log[i].report;
+}
+
+static void check_report(size_t i, uint8_t mods, uint8_t key) {
+    const report_keyboard_t *report = report_at(i);
+    CHECK_EQ(report->mods, mods);
+    CHECK_EQ(report->keys[0], key);
+    for (uint8_t k = 1; k < KEYBOARD_REPORT_KEYS; k++) {
+        CHECK_EQ(report->keys[k], 0);
+    }
+}
+
+// Boots and lets the RGB mode request and first frames settle
+static void boot(void) {
+    sim_boot();
+    sim_run(100);
+    sim_clear_output();
+}
+
+static void first_frame_is_lit(void) {
+    sim_boot();
+    sim_render_frame();
+    uint16_t lit = 0;
+    for (uint8_t i = 0; i < RGB_MATRIX_LED_COUNT / 2; i++) {
+        if (sim_leds[i].r || sim_leds[i].g || sim_leds[i].b) lit++;
+    }
+    CHECK(lit > 0);
+    // The right half's LEDs belong to the other controller
+    for (uint8_t i = RGB_MATRIX_LED_COUNT / 2; i < RGB_MATRIX_LED_COUNT; i++) {
+        CHECK(!sim_leds[i].r && !sim_leds[i].g && !sim_leds[i].b);
+    }
+}
+
+static void tap_sends_key_then_release(void) {
+    boot();
+    sim_tap(K_A, 30);
+    CHECK_EQ(sim_keyboard_log_count, 2);
+    check_report(0, 0, KC_A);
+    check_report(1, 0, 0);
+}
+
+static void momentary_layer_shifted_symbol(void) {
+    boot();
+    sim_key(K_MO1, true);
+    sim_run(50);
+    CHECK(layer_state_is(1));
+    sim_tap(K_L1_EXLM, 30);
+    sim_key(K_MO1, false);
+    sim_run(10);
+    CHECK(layer_state_is(0));
+    // Weak shift goes out on its own around the key, as QMK's
+    // register_code16() sends it
+    CHECK_EQ(sim_keyboard_log_count, 4);
+    check_report(0, MOD_LSFT, 0);
+    check_report(1, MOD_LSFT, KC_1);
+    check_report(2, MOD_LSFT, 0);
+    check_report(3, 0, 0);
+}
+
+static void oneshot_shift_applies_to_next_key_only(void) {
+    boot();
+    sim_tap(K_OS_SHFT, 20);
+    CHECK_EQ(get_oneshot_state(0), os_up_queued);
+    sim_run(20);
+    sim_tap(K_A, 20);
+    sim_run(20);
+    sim_tap(K_R, 20);
+    CHECK_EQ(get_oneshot_state(0), os_up_unqueued);
+
+    // Shift goes down with the oneshot and up with the release of A
+    check_report(0, MOD_LSFT, 0);
+    check_report(1, MOD_LSFT, KC_A);
+    check_report(2, 0, 0);
+    check_report(3, 0, KC_R);
+    check_report(4, 0, 0);
+}
+
+static void oneshot_ctrl_carries_across_layers(void) {
+    boot();
+    sim_key(K_MO2, true);
+    sim_run(50);
+    CHECK(layer_state_is(2));
+    sim_tap(K_L2_OS_CTRL, 20);
+    sim_key(K_MO2, false);
+    sim_run(20);
+    sim_tap(K_A, 20);
+    CHECK_EQ(get_oneshot_state(1), os_up_unqueued);
+
+    bool ctrl_a = false;
+    for (size_t i = 0; i < sim_keyboard_log_count; i++) {
+        if (report_at(i)->mods == MOD_LCTL && report_at(i)->keys[0] == KC_A) ctrl_a = true;
+    }
+    CHECK(ctrl_a);
+    CHECK_EQ(sim_host_mods(), 0);
+}
+
+static void both_layer_thumbs_reach_layer3(void) {
+    boot();
+    sim_key(K_MO1, true);
+    sim_run(10);
+    sim_key(K_MO2, true);
+    sim_run(10);
+    CHECK(layer_state_is(3));
+    sim_key(K_MO2, false);
+    sim_key(K_MO1, false);
+    sim_run(10);
+    CHECK(layer_state_is(0));
+    CHECK_EQ(sim_keyboard_log_count, 0);
+}
+
+static void arrow_macro_types_in_order(void) {
+    boot();
+    sim_key(K_MO1, true);
+    sim_run(50);
+    sim_tap(K_L1_ARROW_R, 20);
+    sim_run(100);
+    sim_key(K_MO1, false);
+
+    // "->": one report per tap edge, the shift riding with the period
+    static const struct {
+        uint8_t mods, key;
+    } expected[] = {
+        {0, KC_MINS}, {0, 0}, {MOD_LSFT, KC_DOT}, {0, 0},
+    };
+    CHECK_EQ(sim_keyboard_log_count, sizeof(expected) / sizeof(expected[0]));
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        check_report(i, expected[i].mods, expected[i].key);
+    }
+}
+
+static void state_sync_only_on_change(void) {
+    boot();
+    sim_run(200);
+    uint32_t before = sim_counters.transactions;
+    sim_run(500);
+    CHECK_EQ(sim_counters.transactions, before);
+
+    // Held, then queued on release: one transaction per change
+    sim_tap(K_OS_SHFT, 20);
+    sim_run(5);
+    CHECK_EQ(sim_counters.transactions, before + 2);
+    // Version byte, then the state word: rgb_enabled and a queued slot 0
+    CHECK_EQ(sim_transaction_length[USER_SYNC_STATE], 3);
+    uint16_t state = sim_transaction_data[USER_SYNC_STATE][1] | sim_transaction_data[USER_SYNC_STATE][2] << 8;
+    CHECK_EQ(state, 0x0101);
+}
+
+static void failed_sync_is_retried(void) {
+    boot();
+    sim_transactions_ok = false;
+    sim_tap(K_OS_SHFT, 20);
+    sim_run(25);
+    CHECK(sim_counters.transactions >= 3);
+    sim_transactions_ok = true;
+    uint32_t sent = sim_counters.transactions;
+    sim_run(50);
+    CHECK_EQ(sim_counters.transactions, sent + 1);
+}
+
+static void slave_mirrors_oneshot_state(void) {
+    sim_master = false;
+    sim_left   = false;
+    boot();
+    const uint8_t payload[] = {1, 0x01, 0x01 << 2};
+    sim_transaction_receive(USER_SYNC_STATE, payload, sizeof(payload));
+    CHECK_EQ(get_oneshot_state(1), os_up_queued);
+    // A heartbeat repeating the applied version and state is skipped
+    set_oneshot_state(1, os_up_unqueued);
+    sim_transaction_receive(USER_SYNC_STATE, payload, sizeof(payload));
+    CHECK_EQ(get_oneshot_state(1), os_up_unqueued);
+}
+
+// A master that resets counts versions from 0 again, behind what the slave
+// applied last, and the slave follows it
+static void slave_follows_master_reset(void) {
+    sim_master = false;
+    sim_left   = false;
+    boot();
+    const uint8_t before_reset[] = {100, 0x01, 0x01 << 2};
+    sim_transaction_receive(USER_SYNC_STATE, before_reset, sizeof(before_reset));
+    CHECK_EQ(get_oneshot_state(1), os_up_queued);
+
+    const uint8_t after_reset[] = {0, 0x01, 0};
+    sim_transaction_receive(USER_SYNC_STATE, after_reset, sizeof(after_reset));
+    CHECK_EQ(get_oneshot_state(1), os_up_unqueued);
+    const uint8_t next[] = {1, 0x01, 0x01 << 4};
+    sim_transaction_receive(USER_SYNC_STATE, next, sizeof(next));
+    CHECK_EQ(get_oneshot_state(2), os_up_queued);
+}
+
+#ifdef RAW_ENABLE
+static void raw_hid_answers_unknown_commands(void) {
+    boot();
+    uint8_t data[32] = {0x01};
+    raw_hid_receive(data, sizeof(data));
+    CHECK_EQ(sim_raw_hid_reply_length, 32);
+    CHECK_EQ(sim_raw_hid_reply[0], 0xFF);
+}
+#endif
+
+// ----------------------------------------------------------------------------
+// Benchmarks
+// ----------------------------------------------------------------------------
+
+#define BENCH_EVENTS 500000
+#define BENCH_RUNS 15
+
+// Press and release records for the basic keys of a layer's letter block,
+// with their keycodes
+static uint8_t bench_records(uint8_t layer, keyrecord_t *records, uint16_t *keycodes) {
+    static const uint8_t rows[] = {0, 1, 2, 4, 5, 6};
+    uint8_t              count  = 0;
+    for (uint8_t r = 0; r < 6; r++) {
+        for (uint8_t col = 1; col <= 5; col++) {
+            uint16_t keycode = keymaps[layer][rows[r]][col];
+            if (keycode < KC_A || keycode > KC_SLSH) continue;
+            keypos_t key        = {.col = col, .row = rows[r]};
+            records[count]      = (keyrecord_t){.event = {.key = key, .type = 1, .pressed = true}};
+            records[count + 1]  = (keyrecord_t){.event = {.key = key, .type = 1, .pressed = false}};
+            keycodes[count]     = keycode;
+            keycodes[count + 1] = keycode;
+            count += 2;
+        }
+    }
+    return count;
+}
+
+// One run of process_record_user() alone over the records, in ns per event.
+// Nothing downstream of it runs, so the harness's reports stay out of the
+// timing.
+static double time_events(const keyrecord_t *records, const uint16_t *keycodes, uint8_t count) {
+    double start = test_seconds();
+    for (uint32_t n = 0; n < BENCH_EVENTS; n++) {
+        keyrecord_t record = records[n % count];
+        process_record_user(keycodes[n % count], &record);
+    }
+    return (test_seconds() - start) / BENCH_EVENTS * 1e9;
+}
+
+// The fast path, taken with no oneshot engaged, against the full path
+// through process_record_keymap() on every layer. A oneshot held down and
+// already used forces the full path and changes no mods, so both do the
+// same work apart from what the fast path skips.
+static void bench_event_path(void) {
+    static keyrecord_t records[60];
+    static uint16_t    keycodes[60];
+    boot();
+    for (uint8_t layer = 0; layer < 6; layer++) {
+        layer_move(layer);
+        uint8_t count = bench_records(layer, records, keycodes);
+        if (!count) continue;
+        // Runs alternate, and the best of each is kept, so drift on the
+        // host hits both alike
+        double fast = 0, full = 0;
+        for (uint8_t run = 0; run < BENCH_RUNS; run++) {
+            set_oneshot_state(0, os_up_unqueued);
+            double t = time_events(records, keycodes, count);
+            if (!run || t < fast) fast = t;
+            set_oneshot_state(0, os_down_used);
+            t = time_events(records, keycodes, count);
+            if (!run || t < full) full = t;
+            CHECK_EQ(get_oneshot_state(0), os_down_used);
+        }
+        printf("layer %u: %5.1f ns/event fast path, %5.1f ns/event full path (%2u keys)\n", layer, fast, full, count / 2);
+    }
+}
+
+static const test_case_t tests[] = {
+    TEST_CASE(first_frame_is_lit),
+    TEST_CASE(tap_sends_key_then_release),
+    TEST_CASE(momentary_layer_shifted_symbol),
+    TEST_CASE(oneshot_shift_applies_to_next_key_only),
+    TEST_CASE(oneshot_ctrl_carries_across_layers),
+    TEST_CASE(both_layer_thumbs_reach_layer3),
+    TEST_CASE(arrow_macro_types_in_order),
+    TEST_CASE(state_sync_only_on_change),
+    TEST_CASE(failed_sync_is_retried),
+    TEST_CASE(slave_mirrors_oneshot_state),
+    TEST_CASE(slave_follows_master_reset),
+#ifdef RAW_ENABLE
+    TEST_CASE(raw_hid_answers_unknown_commands),
+#endif
+};
+
+static const test_case_t benches[] = {
+    TEST_CASE(bench_event_path),
+};
+
+TEST_MAIN(tests, benches)
@@ -0,0 +1,219 @@
+// The mouse engine on layer 3: reference trajectories against
+// golden/mouse/, and properties of the motion model.
+
+#include "test.h"
+#include "trace.h"
+#include "mouse_engine.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Layer 3 positions; right-half columns are mirrored
+#define K_MS_L 1, 1
+#define K_MS_U 1, 2
+#define K_MS_D 1, 3
+#define K_MS_R 1, 4
+#define K_BTN1 1, 5
+#define K_ACL0 0, 4
+#define K_ACL2 4, 5
+#define K_WH_D 5, 4
+#define K_WH_U 5, 3
+
+static void boot(void) {
+    sim_boot();
+    layer_move(3);
+    sim_run(100);
+    sim_clear_output();
+}
+
+static void golden_mouse(const char *name) {
+    char  *text;
+    size_t size;
+    FILE  *out = open_memstream(&text, &size);
+    trace_print_reports(out);
+    fclose(out);
+
+    char path[64];
+    snprintf(path, sizeof(path), "mouse/%s.txt", name);
+    test_golden(path, text);
+    free(text);
+}
+
+static int32_t sum_x(void) {
+    int32_t x = 0;
+    for (size_t i = 0; i < sim_mouse_log_count; i++) x += sim_mouse_log[i].report.x;
+    return x;
+}
+
+static int32_t sum_y(void) {
+    int32_t y = 0;
+    for (size_t i = 0; i < sim_mouse_log_count; i++) y += sim_mouse_log[i].report.y;
+    return y;
+}
+
+// Ease in to full speed, hold, ease out to a stop
+static void right_ease_in_out(void) {
+    boot();
+    sim_tap(K_MS_R, 500);
+    sim_run(500);
+    golden_mouse("right");
+}
+
+static void diagonal_up_right(void) {
+    boot();
+    sim_key(K_MS_U, true);
+    sim_key(K_MS_R, true);
+    sim_run(500);
+    sim_key(K_MS_U, false);
+    sim_key(K_MS_R, false);
+    sim_run(500);
+    golden_mouse("diagonal");
+}
+
+static void speed_steps(void) {
+    boot();
+    sim_key(K_ACL0, true);
+    sim_tap(K_MS_D, 300);
+    sim_key(K_ACL0, false);
+    sim_run(300);
+    sim_key(K_ACL2, true);
+    sim_tap(K_MS_L, 300);
+    sim_key(K_ACL2, false);
+    sim_run(300);
+    golden_mouse("speeds");
+}
+
+static void wheel_and_click(void) {
+    boot();
+    sim_tap(K_WH_D, 1000);
+    sim_run(300);
+    sim_tap(K_WH_U, 200);
+    sim_run(300);
+    sim_tap(K_BTN1, 50);
+    // A high-resolution wheel reports in fractions of a detent
+    golden_mouse(MOUSE_ENGINE_WHEEL_MULTIPLIER > 1 ? "wheel_click_hires" : "wheel_click");
+}
+
+// Each axis of a diagonal covers 1/sqrt(2) of a straight line's distance
+static void diagonal_is_normalized(void) {
+    boot();
+    sim_tap(K_MS_R, 1000);
+    sim_run(500);
+    int32_t straight = sum_x();
+
+    boot();
+    sim_key(K_MS_D, true);
+    sim_tap(K_MS_R, 1000);
+    sim_key(K_MS_D, false);
+    sim_run(500);
+    int32_t x = sum_x(), y = sum_y();
+    CHECK_EQ(x, y);
+    CHECK(abs(x * 1000 / straight - 707) <= 10);
+}
+
+// Sub-pixel carry: a slow speed over many steps adds up to its nominal
+// distance, even though each step is below a pixel at the start
+static void slow_motion_accumulates(void) {
+    boot();
+    sim_key(K_ACL0, true);
+    sim_tap(K_MS_R, 2000);
+    sim_key(K_ACL0, false);
+    sim_run(500);
+    // 200 px/s for 2 s, less the ease in, plus the ease out
+    int32_t x = sum_x();
+    CHECK(x > 360 && x < 420);
+}
+
+static int32_t sum_v(void) {
+    int32_t v = 0;
+    for (size_t i = 0; i < sim_mouse_log_count; i++) v += sim_mouse_log[i].report.v;
+    return v;
+}
+
+// The slowest wheel speed is a fraction of a unit per step, and still adds
+// up to its nominal number of detents
+static void slow_wheel_accumulates(void) {
+    boot();
+    sim_key(K_ACL0, true);
+    sim_tap(K_WH_D, 2000);
+    sim_key(K_ACL0, false);
+    sim_run(500);
+    // 4 detents/s for 2 s, less the ease in, plus the ease out
+    int32_t v = -sum_v();
+    CHECK(v >= 7 * MOUSE_ENGINE_WHEEL_MULTIPLIER - MOUSE_ENGINE_WHEEL_MULTIPLIER / 2);
+    CHECK(v <= 8 * MOUSE_ENGINE_WHEEL_MULTIPLIER + MOUSE_ENGINE_WHEEL_MULTIPLIER / 2);
+}
+
+// Releasing one speed key while another is held keeps the held one's speed
+static void release_falls_back_to_held_speed(void) {
+    boot();
+    sim_key(K_ACL2, true);
+    sim_tap(K_MS_R, 1000);
+    sim_run(500);
+    int32_t fast = sum_x();
+
+    boot();
+    sim_key(K_ACL2, true);
+    sim_tap(K_ACL0, 50);
+    sim_tap(K_MS_R, 1000);
+    sim_run(500);
+    CHECK_EQ(sum_x(), fast);
+}
+
+static void no_reports_when_idle(void) {
+    boot();
+    sim_tap(K_MS_U, 200);
+    sim_run(500);
+    size_t count = sim_mouse_log_count;
+    CHECK(count > 0);
+    sim_run(2000);
+    CHECK_EQ(sim_mouse_log_count, count);
+}
+
+// Reports are sent at most once per interval, and the same key timeline
+// from boot gives the same reports
+static void same_timeline_same_reports(void) {
+    boot();
+    sim_key(K_MS_L, true);
+    sim_key(K_WH_D, true);
+    sim_run(700);
+    sim_key(K_MS_L, false);
+    sim_key(K_WH_D, false);
+    sim_run(500);
+    for (size_t i = 1; i < sim_mouse_log_count; i++) {
+        CHECK(sim_mouse_log[i].time - sim_mouse_log[i - 1].time >= MOUSE_ENGINE_INTERVAL_MS);
+    }
+
+    size_t          count = sim_mouse_log_count;
+    report_mouse_t *first = malloc(count * sizeof(*first));
+    for (size_t i = 0; i < count; i++) first[i] = sim_mouse_log[i].report;
+
+    boot();
+    sim_key(K_MS_L, true);
+    sim_key(K_WH_D, true);
+    sim_run(700);
+    sim_key(K_MS_L, false);
+    sim_key(K_WH_D, false);
+    sim_run(500);
+    CHECK_EQ(sim_mouse_log_count, count);
+    for (size_t i = 0; i < count; i++) {
+        CHECK(memcmp(&first[i], &sim_mouse_log[i].report, sizeof(*first)) == 0);
+    }
+    free(first);
+}
+
+static const test_case_t tests[] = {
+    TEST_CASE(right_ease_in_out),
+    TEST_CASE(diagonal_up_right),
+    TEST_CASE(speed_steps),
+    TEST_CASE(wheel_and_click),
+    TEST_CASE(diagonal_is_normalized),
+    TEST_CASE(slow_motion_accumulates),
+    TEST_CASE(slow_wheel_accumulates),
+    TEST_CASE(release_falls_back_to_held_speed),
+    TEST_CASE(no_reports_when_idle),
+    TEST_CASE(same_timeline_same_reports),
+};
+
+static const test_case_t benches[] = {};
+
+TEST_MAIN(tests, benches)
@@ -0,0 +1,232 @@
+// Oneshot mods: the bitmask engine against the four-call state machine it
+// replaced, end-to-end streams through the keymap, and their cost.
+
+#include "test.h"
+#include "oneshot.h"
+
+// ----------------------------------------------------------------------------
+// Reference: the per-mod update_oneshot() the keymap called once per oneshot
+// key before the bitmask engine, with register/unregister_code counted into
+// a mod mask instead of sent
+// ----------------------------------------------------------------------------
+
+typedef struct {
+    oneshot_state state[4];
+    uint8_t       mods;
+    uint32_t      calls;
+} reference_t;
+
+static void reference_register(reference_t *ref, uint16_t mod) {
+    ref->mods |= MOD_BIT(mod);
+    ref->calls++;
+}
+
+static void reference_unregister(reference_t *ref, uint16_t mod) {
+    ref->mods &= ~MOD_BIT(mod);
+    ref->calls++;
+}
+
+static void update_oneshot(reference_t *ref, oneshot_state *state, uint16_t mod, uint16_t trigger, uint16_t keycode, keyrecord_t *record) {
+    if (keycode == trigger) {
+        if (record->event.pressed) {
+            if (*state == os_up_unqueued) {
+                reference_register(ref, mod);
+            }
+            *state = os_down_unused;
+        } else {
+            switch (*state) {
+                case os_down_unused:
+                    *state = os_up_queued;
+                    break;
+                case os_down_used:
+                    *state = os_up_unqueued;
+                    reference_unregister(ref, mod);
+                    break;
+                default:
+                    break;
+            }
+        }
+    } else {
+        if (record->event.pressed) {
+            if (is_oneshot_cancel_key(keycode) && *state != os_up_unqueued) {
+                *state = os_up_unqueued;
+                reference_unregister(ref, mod);
+            }
+        } else {
+            if (!is_oneshot_ignored_key(keycode)) {
+                switch (*state) {
+                    case os_down_unused:
+                        *state = os_down_used;
+                        break;
+                    case os_up_queued:
+                        *state = os_up_unqueued;
+                        reference_unregister(ref, mod);
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+}
+
+// The keymap's original four calls, shift, ctrl, alt, cmd
+static void reference_update(reference_t *ref, uint16_t keycode, keyrecord_t *record) {
+    static const uint16_t mods[4] = {KC_LSFT, KC_LCTL, KC_LALT, KC_LGUI};
+    for (uint8_t i = 0; i < 4; i++) {
+        update_oneshot(ref, &ref->state[i], mods[i], oneshot_mods[i].trigger, keycode, record);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Random event streams
+// ----------------------------------------------------------------------------
+
+static uint32_t rng_state = 0x2545F491;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// Triggers, cancel keys, ignored keys and plain keys
+static uint16_t random_keycode(void) {
+    static const uint16_t others[] = {
+        MO(1), MO(2), MO(3), MO(5), KC_BSPC, KC_LSFT, KC_LCTL, KC_LALT, KC_LGUI, KC_A, KC_N, KC_SPC,
+    };
+    uint32_t pick = rng() % (4 + sizeof(others) / sizeof(others[0]));
+    return pick < 4 ? oneshot_mods[pick].trigger : others[pick - 4];
+}
+
+static keyrecord_t random_record(void) {
+    return (keyrecord_t){.event = {.pressed = rng() & 1}};
+}
+
+#define DIFF_EVENTS 200000
+
+static void bitmask_matches_reference(void) {
+    reference_t ref = {0};
+    for (uint32_t n = 0; n < DIFF_EVENTS; n++) {
+        uint16_t    keycode = random_keycode();
+        keyrecord_t record  = random_record();
+        update_oneshot_mods(keycode, &record);
+        reference_update(&ref, keycode, &record);
+        for (uint8_t i = 0; i < 4; i++) {
+            if (get_oneshot_state(i) != ref.state[i]) {
+                test_fail(__FILE__, __LINE__, "event %u (%04X %s): slot %u is %d, reference %d", n, keycode,
+                          record.event.pressed ? "down" : "up", i, get_oneshot_state(i), ref.state[i]);
+            }
+        }
+        if (get_mods() != ref.mods) {
+            test_fail(__FILE__, __LINE__, "event %u (%04X %s): mods %02X, reference %02X", n, keycode,
+                      record.event.pressed ? "down" : "up", get_mods(), ref.mods);
+        }
+    }
+}
+
+// Layer 0 and 2 keys, avoiding MO(1) so the layer 3 chord stays out of it.
+// On layer 2 the home row holds the four oneshot triggers.
+static const keypos_t stream_keys[] = {
+    {.row = 7, .col = 5}, // OS_SHFT
+    {.row = 7, .col = 4}, // MO(2)
+    {.row = 7, .col = 3}, // Backspace, cancels
+    {.row = 3, .col = 5}, // Space
+    {.row = 1, .col = 0}, // Escape, layer 2 Shift
+    {.row = 2, .col = 0}, // Left Ctrl
+    {.row = 1, .col = 1}, // A R S T, layer 2 OS_CTRL OS_SHFT OS_CMD OS_ALT
+    {.row = 1, .col = 2},
+    {.row = 1, .col = 3},
+    {.row = 1, .col = 4},
+    {.row = 5, .col = 5}, // M
+    {.row = 5, .col = 4}, // N
+};
+#define STREAM_KEY_COUNT (sizeof(stream_keys) / sizeof(stream_keys[0]))
+
+// Random presses and releases of the keys above, 5-40 ms apart. Ends with
+// everything released and a tap of a plain key, after which no mod may be
+// left down. Returns true if one was.
+static bool random_stream(uint32_t events) {
+    bool down[STREAM_KEY_COUNT] = {0};
+    for (uint32_t n = 0; n < events; n++) {
+        uint8_t k = rng() % STREAM_KEY_COUNT;
+        down[k]   = !down[k];
+        sim_key(stream_keys[k].row, stream_keys[k].col, down[k]);
+        sim_run(5 + rng() % 36);
+    }
+    for (uint8_t k = 0; k < STREAM_KEY_COUNT; k++) {
+        if (down[k]) sim_key(stream_keys[k].row, stream_keys[k].col, false);
+    }
+    sim_run(10);
+    sim_tap(2, 4, 20);
+    sim_run(10);
+    return sim_host_mods() != 0 || get_mods() != 0;
+}
+
+static void random_streams_leave_no_mod_down(void) {
+    sim_boot();
+    for (int stream = 0; stream < 200; stream++) {
+        if (random_stream(200)) test_fail(__FILE__, __LINE__, "stream %d left mods %02X", stream, sim_host_mods());
+        CHECK(layer_state_is(0));
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Benchmarks
+// ----------------------------------------------------------------------------
+
+#define BENCH_EVENTS 2000000
+
+static void bench_engine(void) {
+    static uint16_t    keycodes[4096];
+    static keyrecord_t records[4096];
+    for (int i = 0; i < 4096; i++) {
+        keycodes[i] = random_keycode();
+        records[i]  = random_record();
+    }
+
+    double start = test_seconds();
+    for (uint32_t n = 0; n < BENCH_EVENTS; n++) {
+        update_oneshot_mods(keycodes[n & 4095], &records[n & 4095]);
+    }
+    double      bitmask = test_seconds() - start;
+    uint32_t    calls   = sim_counters.mod_calls;
+    reference_t ref     = {0};
+    start               = test_seconds();
+    for (uint32_t n = 0; n < BENCH_EVENTS; n++) {
+        reference_update(&ref, keycodes[n & 4095], &records[n & 4095]);
+    }
+    double reference = test_seconds() - start;
+
+    printf("engine: bitmask %.1f Mevents/s, %.3f mod calls/event; four-call %.1f Mevents/s, %.3f register/unregister calls/event\n",
+           BENCH_EVENTS / bitmask / 1e6, (double)calls / BENCH_EVENTS, BENCH_EVENTS / reference / 1e6,
+           (double)ref.calls / BENCH_EVENTS);
+}
+
+static void bench_keymap(void) {
+    sim_boot();
+    uint32_t streams = 0, stuck = 0;
+    double   start = test_seconds();
+    while (sim_counters.events < 500000) {
+        stuck += random_stream(500);
+        streams++;
+    }
+    double elapsed = test_seconds() - start;
+
+    printf("keymap: %.0f events/s with scans, %.3f register/unregister + %.3f mod calls/event, %.3f reports/event, %u/%u streams with stuck mods\n",
+           sim_counters.events / elapsed, (double)sim_counters.code_calls / sim_counters.events,
+           (double)sim_counters.mod_calls / sim_counters.events, (double)sim_counters.reports / sim_counters.events, stuck, streams);
+}
+
+static const test_case_t tests[] = {
+    TEST_CASE(bitmask_matches_reference),
+    TEST_CASE(random_streams_leave_no_mod_down),
+};
+
+static const test_case_t benches[] = {
+    TEST_CASE(bench_engine),
+    TEST_CASE(bench_keymap),
+};
+
+TEST_MAIN(tests, benches)
@@ -0,0 +1,275 @@
+// LED frames of the layer overlay against golden/frames/, and the cost of
+// rendering them.
+
+#include "test.h"
+#include "oneshot.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Position of RGB_TOG_CUSTOM on layer 3
+#define K_L3_RGB_TOG 0, 1
+
+// Oneshot states to render each layer with, as get_oneshot_packed() would
+// report them: none, a queued Shift, and all four queued
+static const struct {
+    const char *name;
+    uint8_t     queued;  // Slot mask
+} oneshot_cases[] = {
+    {"none", 0x0},
+    {"shift", 0x1},
+    {"all", 0xF},
+};
+
+static void set_queued(uint8_t queued) {
+    for (uint8_t i = 0; i < oneshot_mod_count; i++) {
+        set_oneshot_state(i, (queued >> i) & 1 ? os_up_queued : os_up_unqueued);
+    }
+}
+
+static void toggle_rgb(uint8_t layer) {
+    layer_move(3);
+    sim_tap(K_L3_RGB_TOG, 20);
+    layer_move(layer);
+}
+
+static void print_half(FILE *out) {
+    uint8_t first = sim_left ? 0 : RGB_MATRIX_LED_COUNT / 2;
+    for (uint8_t i = first; i < first + RGB_MATRIX_LED_COUNT / 2; i++) {
+        fprintf(out, "led %2u %3u %3u %3u\n", i, sim_leds[i].r, sim_leds[i].g, sim_leds[i].b);
+    }
+}
+
+// Every combination of RGB toggle and oneshot state on one layer, in one
+// run, so each frame is reached from the previous one through the frame
+// cache as on the keyboard. The right half renders as master.
+static void golden_layer(uint8_t layer, bool left) {
+    char  *text;
+    size_t size;
+    FILE  *out = open_memstream(&text, &size);
+
+    sim_left = left;
+    sim_boot();
+    layer_move(layer);
+    for (uint8_t rgb = 0; rgb < 2; rgb++) {
+        if (rgb) toggle_rgb(layer);
+        for (uint8_t o = 0; o < sizeof(oneshot_cases) / sizeof(oneshot_cases[0]); o++) {
+            set_queued(oneshot_cases[o].queued);
+            // Past the layer crossfade and the mode debounce
+            sim_run(300);
+            sim_render_frame();
+            fprintf(out, "# rgb_enabled %s, oneshot %s, %u ms\n", rgb ? "off" : "on", oneshot_cases[o].name, (unsigned)sim_now);
+            print_half(out);
+        }
+    }
+    fclose(out);
+
+    // A governor budget scales the frames, and the heatmap replaces the
+    // layer 3 scheme
+    char dir[32] = "frames";
+#ifdef RGB_GOVERNOR_BUDGET_MA
+    snprintf(dir, sizeof(dir), "frames/%umA", RGB_GOVERNOR_BUDGET_MA);
+#endif
+#ifdef HEATMAP_ENABLE
+    const char *suffix = layer == 3 ? "_heatmap" : "";
+#else
+    const char *suffix = "";
+#endif
+    char name[64];
+    snprintf(name, sizeof(name), "%s/layer%u%s_%s.txt", dir, layer, suffix, left ? "left" : "right");
+    test_golden(name, text);
+    free(text);
+}
+
+#define FRAME_TESTS(layer)                        \
+    static void frames_layer##layer##_left(void) {  \
+        golden_layer(layer, true);                \
+    }                                             \
+    static void frames_layer##layer##_right(void) { \
+        golden_layer(layer, false);               \
+    }
+
+FRAME_TESTS(0)
+FRAME_TESTS(1)
+FRAME_TESTS(2)
+FRAME_TESTS(3)
+FRAME_TESTS(4)
+FRAME_TESTS(5)
+
+// Over a breath cycle on the breathing layers, only the breathing LEDs
+// change, and they dip to black. With the full variant's budget the
+// governor scales these frames; its scale used to follow the live draw, so
+// static LEDs pulsed against the breathing ones.
+static void static_leds_hold_through_breath(void) {
+    for (uint8_t layer = 1; layer <= 2; layer++) {
+        sim_boot();
+        layer_move(layer);
+        sim_run(300);
+        RGB  first[RGB_MATRIX_LED_COUNT / 2], low[RGB_MATRIX_LED_COUNT / 2];
+        bool changed[RGB_MATRIX_LED_COUNT / 2] = {0};
+        memcpy(first, sim_leds, sizeof(first));
+        memcpy(low, sim_leds, sizeof(low));
+        for (uint32_t t = 0; t < 4000; t += 8) {
+            sim_input_activity();
+            sim_run(8);
+            for (uint8_t i = 0; i < RGB_MATRIX_LED_COUNT / 2; i++) {
+                if (memcmp(&sim_leds[i], &first[i], sizeof(RGB))) changed[i] = true;
+                if (sim_leds[i].r + sim_leds[i].g + sim_leds[i].b < low[i].r + low[i].g + low[i].b) low[i] = sim_leds[i];
+            }
+        }
+        uint8_t breathing = 0;
+        for (uint8_t i = 0; i < RGB_MATRIX_LED_COUNT / 2; i++) {
+            if (!changed[i]) continue;
+            CHECK_EQ(low[i].r + low[i].g + low[i].b, 0);
+            breathing++;
+        }
+        CHECK(breathing > 0);
+    }
+}
+
+#define BENCH_FRAMES 20000
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Renders frames back to back, the clock moving on by the flush limit
+// between them, and times every chunk. step, if given, runs before each
+// frame outside the timing. Input activity is kept up so the idle tiers
+// stay out of it.
+static void bench_frames(const char *label, void (*step)(uint32_t frame)) {
+    static double chunk_times[BENCH_FRAMES * 8];
+    uint32_t      chunks      = 0;
+    double        chunk_total = 0, frame_total = 0;
+    for (uint32_t f = 0; f < BENCH_FRAMES; f++) {
+        if (step) step(f);
+        sim_input_activity();
+        sim_now += RGB_MATRIX_LED_FLUSH_LIMIT;
+        housekeeping_task_user();
+
+        uint32_t frames      = sim_counters.frames;
+        double   frame_start = test_seconds();
+        while (sim_counters.frames == frames) {
+            uint32_t before = sim_counters.chunks;
+            double   start  = test_seconds();
+            sim_rgb_task();
+            double elapsed = test_seconds() - start;
+            if (sim_counters.chunks != before && chunks < sizeof(chunk_times) / sizeof(chunk_times[0])) {
+                chunk_times[chunks++] = elapsed;
+                chunk_total += elapsed;
+            }
+        }
+        frame_total += test_seconds() - frame_start;
+    }
+    qsort(chunk_times, chunks, sizeof(chunk_times[0]), compare_double);
+    printf("%-18s %6.0f ns/frame, %.1f chunks/frame, %5.0f ns/chunk mean, %5.0f ns p99\n", label, frame_total / BENCH_FRAMES * 1e9,
+           (double)chunks / BENCH_FRAMES, chunk_total / chunks * 1e9, chunk_times[chunks * 99 / 100] * 1e9);
+}
+
+// Taps A every fifth frame
+static void step_typing(uint32_t frame) {
+    if (frame % 5 == 0) {
+        sim_key(1, 1, true);
+        sim_key(1, 1, false);
+    }
+}
+
+// Nudges the base value every frame, which invalidates the layer frame as
+// a layer or HSV change would. Every frame then rebuilds from keymaps[],
+// the work the overlay did on each frame before the cache, plus the start
+// of a crossfade.
+// From keymap.c
+void layer_frame_invalidate(void);
+
+// A rebuild without the crossfade a real change would start
+static void step_rebuild(uint32_t frame) {
+    layer_frame_invalidate();
+}
+
+static void bench_layers(void) {
+    sim_boot();
+    for (uint8_t layer = 0; layer < 6; layer++) {
+        char label[32];
+        layer_move(layer);
+        sim_run(300);
+        snprintf(label, sizeof(label), "layer %u", layer);
+        bench_frames(label, NULL);
+        if (layer == 0) bench_frames("layer 0 typing", step_typing);
+    }
+    layer_move(1);
+    set_oneshot_state(0, os_up_queued);
+    sim_run(300);
+    bench_frames("layer 1 shift", NULL);
+}
+
+// Flicks between layers 0 and 1 every tenth frame, so nearly every frame
+// is inside a crossfade
+static void step_flick(uint32_t frame) {
+    if (frame % 10 == 0) layer_move(frame / 10 & 1);
+}
+
+// Typing at 25 keys/s, with MO(1) flicked in a 100 ms hold every 200 ms if
+// flick is set. Times whole scans: matrix events, RGB task and housekeeping.
+static void bench_scans(const char *label, bool flick) {
+    sim_boot();
+    sim_run(300);
+    uint32_t start_ms = sim_now, frames = sim_counters.frames;
+    double   start    = test_seconds();
+    while (sim_now - start_ms < 200000) {
+        uint32_t t = sim_now - start_ms;
+        if (t % 40 == 0) sim_key(1, 1, true);
+        if (t % 40 == 20) sim_key(1, 1, false);
+        if (flick && t % 200 == 10) sim_key(3, 4, true);
+        if (flick && t % 200 == 110) sim_key(3, 4, false);
+        sim_scan();
+        if (sim_keyboard_log_count > 4096) sim_clear_output();
+    }
+    double elapsed = test_seconds() - start;
+    printf("%-18s %6.0f ns/scan, %.0f scans/s, %u frames\n", label, elapsed / 200000 * 1e9, 200000 / elapsed,
+           (unsigned)(sim_counters.frames - frames));
+}
+
+// Blended frames against steady ones, and the scan cost of MO(1) flicks
+// during typing
+static void bench_crossfade(void) {
+    sim_boot();
+    layer_move(1);
+    sim_run(300);
+    bench_frames("layer 1 steady", NULL);
+    bench_frames("layer 0/1 blending", step_flick);
+    bench_scans("typing", false);
+    bench_scans("typing, MO(1)", true);
+}
+
+// Cached frames against a rebuild on every frame, per layer
+static void bench_cache(void) {
+    sim_boot();
+    for (uint8_t layer = 0; layer < 6; layer++) {
+        char label[32];
+        layer_move(layer);
+        sim_run(300);
+        snprintf(label, sizeof(label), "layer %u cached", layer);
+        bench_frames(label, NULL);
+        snprintf(label, sizeof(label), "layer %u rebuilt", layer);
+        bench_frames(label, step_rebuild);
+        sim_run(300);
+    }
+}
+
+static const test_case_t tests[] = {
+    TEST_CASE(static_leds_hold_through_breath),
+    TEST_CASE(frames_layer0_left), TEST_CASE(frames_layer0_right),
+    TEST_CASE(frames_layer1_left), TEST_CASE(frames_layer1_right),
+    TEST_CASE(frames_layer2_left), TEST_CASE(frames_layer2_right),
+    TEST_CASE(frames_layer3_left), TEST_CASE(frames_layer3_right),
+    TEST_CASE(frames_layer4_left), TEST_CASE(frames_layer4_right),
+    TEST_CASE(frames_layer5_left), TEST_CASE(frames_layer5_right),
+};
+
+static const test_case_t benches[] = {
+    TEST_CASE(bench_layers),
+    TEST_CASE(bench_cache),
+    TEST_CASE(bench_crossfade),
+};
+
+TEST_MAIN(tests, benches)
@@ -0,0 +1,306 @@
+// The ESC/Shift tap-hold key at (1,0) with TAP_HOLD_ENABLE: how each case
+// resolves, and its latency against a stock mod-tap on the same streams.
+
+#include "test.h"
+#include <stdlib.h>
+
+// Matrix positions; right-half columns are mirrored
+#define K_ESC 1, 0
+#define K_A 1, 1
+#define K_R 1, 2
+#define K_N 5, 4
+
+#define MOD_LSFT 0x02
+
+// As in tap_hold.c
+#ifndef TAP_HOLD_TERM
+#    define TAP_HOLD_TERM 150
+#endif
+#ifndef TAP_HOLD_STREAK_MS
+#    define TAP_HOLD_STREAK_MS 100
+#endif
+
+// QMK's default TAPPING_TERM, for the stock mod-tap comparison
+#define STOCK_TAPPING_TERM 200
+
+#ifdef TAP_HOLD_ENABLE
+
+static bool report_has(size_t i, uint8_t key) {
+    for (uint8_t k = 0; k < KEYBOARD_REPORT_KEYS; k++) {
+        if (sim_keyboard_log[i].report.keys[k] == key) return true;
+    }
+    return false;
+}
+
+static void boot(void) {
+    sim_boot();
+    sim_run(300);
+    sim_clear_output();
+}
+
+static void release_is_tap(void) {
+    boot();
+    sim_key(K_ESC, true);
+    sim_run(50);
+    CHECK_EQ(sim_keyboard_log_count, 0);
+    sim_key(K_ESC, false);
+    CHECK_EQ(sim_keyboard_log_count, 2);
+    CHECK(report_has(0, KC_ESC));
+    CHECK_EQ(sim_keyboard_log[0].report.mods, 0);
+    CHECK(!report_has(1, KC_ESC));
+}
+
+static void undecided_past_term_is_hold(void) {
+    boot();
+    uint32_t pressed = sim_now;
+    sim_key(K_ESC, true);
+    sim_run(TAP_HOLD_TERM + 20);
+    CHECK_EQ(sim_keyboard_log_count, 1);
+    CHECK_EQ(sim_keyboard_log[0].report.mods, MOD_LSFT);
+    CHECK(sim_keyboard_log[0].time - pressed <= TAP_HOLD_TERM + 1);
+    sim_key(K_ESC, false);
+    CHECK_EQ(sim_keyboard_log_count, 2);
+    CHECK_EQ(sim_keyboard_log[1].report.mods, 0);
+}
+
+static void press_during_streak_taps_at_once(void) {
+    boot();
+    sim_tap(K_A, 30);
+    sim_run(TAP_HOLD_STREAK_MS / 2);
+    sim_clear_output();
+    sim_key(K_ESC, true);
+    CHECK_EQ(sim_keyboard_log_count, 1);
+    CHECK(report_has(0, KC_ESC));
+    // Held past the term it stays a tap
+    sim_run(TAP_HOLD_TERM + 20);
+    sim_key(K_ESC, false);
+    CHECK_EQ(sim_keyboard_log_count, 2);
+    CHECK_EQ(sim_keyboard_log[1].report.mods, 0);
+}
+
+// N tapped while Escape is held: Shift goes out with N, in one report
+static void other_half_tap_within_is_hold(void) {
+    boot();
+    sim_key(K_ESC, true);
+    sim_run(30);
+    sim_key(K_N, true);
+    CHECK_EQ(sim_keyboard_log_count, 0);
+    sim_run(20);
+    sim_key(K_N, false);
+    CHECK_EQ(sim_keyboard_log_count, 2);
+    CHECK_EQ(sim_keyboard_log[0].report.mods, MOD_LSFT);
+    CHECK(report_has(0, KC_N));
+    CHECK_EQ(sim_keyboard_log[1].report.mods, MOD_LSFT);
+    CHECK(!report_has(1, KC_N));
+    sim_key(K_ESC, false);
+    CHECK_EQ(sim_host_mods(), 0);
+}
+
+// Escape released before N: a roll across the halves, not a Shift
+static void other_half_roll_is_tap(void) {
+    boot();
+    sim_key(K_ESC, true);
+    sim_run(30);
+    sim_key(K_N, true);
+    sim_run(20);
+    sim_key(K_ESC, false);
+    sim_key(K_N, false);
+    for (size_t i = 0; i < sim_keyboard_log_count; i++) {
+        CHECK_EQ(sim_keyboard_log[i].report.mods, 0);
+    }
+    CHECK(report_has(0, KC_ESC));
+    CHECK(report_has(1, KC_N));
+}
+
+static void same_half_press_is_roll(void) {
+    boot();
+    sim_key(K_ESC, true);
+    sim_run(30);
+    sim_key(K_R, true);
+    CHECK_EQ(sim_keyboard_log_count, 2);
+    CHECK(report_has(0, KC_ESC));
+    CHECK(report_has(1, KC_R));
+    CHECK_EQ(sim_keyboard_log[1].report.mods, 0);
+    sim_key(K_ESC, false);
+    sim_key(K_R, false);
+    CHECK(!report_has(sim_keyboard_log_count - 1, KC_R));
+}
+
+// ----------------------------------------------------------------------------
+// Latency against a stock mod-tap
+// ----------------------------------------------------------------------------
+
+typedef struct {
+    uint32_t time;
+    uint8_t  row, col;
+    bool     pressed;
+} stream_event_t;
+
+typedef struct {
+    uint32_t press, release;
+    uint8_t  row, col, keycode;
+} stream_key_t;
+
+#define STREAM_KEYS 20000
+
+static stream_key_t   keys[STREAM_KEYS];
+static stream_event_t events[STREAM_KEYS * 2];
+
+static uint32_t rng_state = 0x9E3779B9;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static int compare_events(const void *a, const void *b) {
+    const stream_event_t *x = a, *y = b;
+    if (x->time != y->time) return x->time < y->time ? -1 : 1;
+    return x->pressed - y->pressed;  // Releases first
+}
+
+// Typing with an Escape tap every fifth key: presses 60-250 ms apart, letters
+// held 20-55 ms and Escape 40-120 ms, so Escape sometimes rolls into the next
+// key. Letters alternate at random between A on the left and N on the right.
+static void generate_stream(void) {
+    uint32_t t = 0;
+    for (uint32_t i = 0; i < STREAM_KEYS; i++) {
+        t += 60 + rng() % 191;
+        stream_key_t *key = &keys[i];
+        if (i % 5 == 4) {
+            *key = (stream_key_t){t, t + 40 + rng() % 81, K_ESC, KC_ESC};
+        } else if (rng() & 1) {
+            *key = (stream_key_t){t, t + 20 + rng() % 36, K_A, KC_A};
+        } else {
+            *key = (stream_key_t){t, t + 20 + rng() % 36, K_N, KC_N};
+        }
+        events[i * 2]     = (stream_event_t){key->press, key->row, key->col, true};
+        events[i * 2 + 1] = (stream_event_t){key->release, key->row, key->col, false};
+    }
+    qsort(events, STREAM_KEYS * 2, sizeof(events[0]), compare_events);
+}
+
+typedef struct {
+    uint64_t esc_delay, esc_taps, other_delay, delayed;
+    uint32_t esc_max, other_max, holds;
+    uint32_t roll_holds;  // Holds with no other-half key tapped inside
+} latency_t;
+
+// Whether the key after an Escape is an N pressed and released inside it,
+// which the resolver takes for Shift-N. Presses are at least 60 ms apart
+// and Escape is held at most 120 ms, so only the next key can be inside.
+static bool is_nested(uint32_t i) {
+    return i + 1 < STREAM_KEYS && keys[i + 1].keycode == KC_N && keys[i + 1].release < keys[i].release;
+}
+
+static void add_delay(latency_t *l, bool esc, uint32_t delay) {
+    if (esc) {
+        l->esc_delay += delay;
+        l->esc_taps++;
+        if (delay > l->esc_max) l->esc_max = delay;
+    } else {
+        l->other_delay += delay;
+        if (delay) l->delayed++;
+        if (delay > l->other_max) l->other_max = delay;
+    }
+}
+
+// A stock mod-tap without PERMISSIVE_HOLD or HOLD_ON_OTHER_KEY_PRESS: a tap
+// when released within the tapping term, sent on release, and a hold at the
+// term otherwise. Keys pressed meanwhile wait for the decision.
+static latency_t stock_latency(void) {
+    latency_t l           = {0};
+    uint32_t  pending_end = 0;
+    for (uint32_t i = 0; i < STREAM_KEYS; i++) {
+        const stream_key_t *key = &keys[i];
+        if (key->keycode == KC_ESC) {
+            uint32_t held = key->release - key->press;
+            if (held < STOCK_TAPPING_TERM) {
+                add_delay(&l, true, held);
+                pending_end = key->release;
+            } else {
+                l.holds++;
+                pending_end = key->press + STOCK_TAPPING_TERM;
+            }
+        } else {
+            add_delay(&l, false, key->press < pending_end ? pending_end - key->press : 0);
+        }
+    }
+    return l;
+}
+
+// Replays the stream through the keymap and finds each press's first report
+static latency_t resolver_latency(void) {
+    sim_boot();
+    sim_run(300);
+    sim_clear_output();
+    uint32_t start = sim_now;
+    for (uint32_t i = 0; i < STREAM_KEYS * 2; i++) {
+        if ((int32_t)(start + events[i].time - sim_now) > 0) sim_run(start + events[i].time - sim_now);
+        sim_key(events[i].row, events[i].col, events[i].pressed);
+    }
+    sim_run(500);
+
+    latency_t l = {0};
+    size_t    r = 0;
+    for (uint32_t i = 0; i < STREAM_KEYS; i++) {
+        const stream_key_t *key = &keys[i];
+        while (r < sim_keyboard_log_count && sim_keyboard_log[r].time < start + key->press) r++;
+        size_t s = r;
+        while (s < sim_keyboard_log_count && !report_has(s, key->keycode) &&
+               !(key->keycode == KC_ESC && sim_keyboard_log[s].report.mods & MOD_LSFT)) {
+            s++;
+        }
+        CHECK(s < sim_keyboard_log_count);
+        if (!report_has(s, key->keycode)) {
+            l.holds++;
+            if (!is_nested(i)) l.roll_holds++;
+            continue;
+        }
+        add_delay(&l, key->keycode == KC_ESC, sim_keyboard_log[s].time - start - key->press);
+    }
+    return l;
+}
+
+static void print_latency(const char *label, const latency_t *l) {
+    uint32_t others = STREAM_KEYS - l->esc_taps - l->holds;
+    printf("%-30s Escape %5.1f ms mean, %3u ms max; other keys %4.1f ms mean, %3u ms max, %u delayed; %u taps read as holds, %u "
+           "of them rolls\n",
+           label, (double)l->esc_delay / l->esc_taps, l->esc_max, (double)l->other_delay / others, l->other_max, (unsigned)l->delayed,
+           l->holds, l->roll_holds);
+}
+
+static void bench_latency(void) {
+    generate_stream();
+    latency_t stock    = stock_latency();
+    latency_t resolver = resolver_latency();
+    print_latency("stock mod-tap, 200 ms term", &stock);
+    print_latency("tap_hold.c", &resolver);
+    // Only an N tapped inside Escape may read as Shift
+    CHECK_EQ(resolver.roll_holds, 0);
+}
+
+static const test_case_t tests[] = {
+    TEST_CASE(release_is_tap),
+    TEST_CASE(undecided_past_term_is_hold),
+    TEST_CASE(press_during_streak_taps_at_once),
+    TEST_CASE(other_half_tap_within_is_hold),
+    TEST_CASE(other_half_roll_is_tap),
+    TEST_CASE(same_half_press_is_roll),
+};
+
+static const test_case_t benches[] = {
+    TEST_CASE(bench_latency),
+};
+
+#else
+
+// Nothing to test without the resolver
+static const test_case_t tests[]   = {};
+static const test_case_t benches[] = {};
+
+#endif
+
+TEST_MAIN(tests, benches)
@@ -0,0 +1,64 @@
+// Replays every trace in traces/ and compares the reports the host gets with
+// golden/<trace>.txt. Run "make golden" after an intended change.
+
+#include "test.h"
+#include "trace.h"
+#include <stdlib.h>
+
+static void replay_golden(const char *name) {
+    char path[256];
+    snprintf(path, sizeof(path), "traces/%s.trace", name);
+    trace_t trace;
+    CHECK(trace_load(path, &trace));
+
+    sim_boot();
+    trace_replay(&trace, 500);
+    trace_free(&trace);
+
+    char  *text;
+    size_t size;
+    FILE  *out = open_memstream(&text, &size);
+    trace_print_reports(out);
+    fclose(out);
+
+    snprintf(path, sizeof(path), "%s.txt", name);
+    test_golden(path, text);
+    free(text);
+}
+
+static void typing(void) {
+    replay_golden("typing");
+}
+
+static void symbols(void) {
+    replay_golden("symbols");
+}
+
+static void layer3(void) {
+    replay_golden("layer3");
+}
+
+static void oneshot_stack(void) {
+    replay_golden("oneshot_stack");
+}
+
+static void oneshot_hold(void) {
+    replay_golden("oneshot_hold");
+}
+
+static void oneshot_cancel(void) {
+    replay_golden("oneshot_cancel");
+}
+
+static const test_case_t tests[] = {
+    TEST_CASE(typing),
+    TEST_CASE(symbols),
+    TEST_CASE(layer3),
+    TEST_CASE(oneshot_stack),
+    TEST_CASE(oneshot_hold),
+    TEST_CASE(oneshot_cancel),
+};
+
+static const test_case_t benches[] = {};
+
+TEST_MAIN(tests, benches)
@@ -0,0 +1,85 @@
+#include "trace.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool trace_load(const char *path, trace_t *trace) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "%s: can't open\n", path);
+        return false;
+    }
+
+    size_t capacity = 0;
+    char   line[256];
+    int    number = 0;
+    *trace        = (trace_t){0};
+    while (fgets(line, sizeof(line), file)) {
+        number++;
+        char *comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        unsigned time, row, col;
+        char     action[8];
+        int      fields = sscanf(line, "%u %7s %u %u", &time, action, &row, &col);
+        if (fields <= 0) continue;
+
+        bool down = strcmp(action, "down") == 0;
+        if (fields != 4 || (!down && strcmp(action, "up") != 0) || row >= MATRIX_ROWS || col >= MATRIX_COLS ||
+            (trace->count && time < trace->events[trace->count - 1].time)) {
+            fprintf(stderr, "%s:%d: bad event\n", path, number);
+            fclose(file);
+            trace_free(trace);
+            return false;
+        }
+
+        if (trace->count == capacity) {
+            capacity       = capacity ? capacity * 2 : 64;
+            trace->events = realloc(trace->events, capacity * sizeof(*trace->events));
+        }
+        trace->events[trace->count++] = (trace_event_t){time, row, col, down};
+    }
+    fclose(file);
+    return true;
+}
+
+void trace_free(trace_t *trace) {
+    free(trace->events);
+    *trace = (trace_t){0};
+}
+
+void trace_replay(const trace_t *trace, uint32_t tail_ms) {
+    uint32_t start = sim_now;
+    for (size_t i = 0; i < trace->count; i++) {
+        const trace_event_t *event = &trace->events[i];
+        // A scan can overrun its millisecond when the keymap waits
+        if ((int32_t)(start + event->time - sim_now) > 0) sim_run(start + event->time - sim_now);
+        sim_key(event->row, event->col, event->pressed);
+    }
+    sim_run(tail_ms);
+}
+
+void trace_print_reports(FILE *out) {
+    size_t k = 0, m = 0;
+    while (k < sim_keyboard_log_count || m < sim_mouse_log_count) {
+        if (k < sim_keyboard_log_count && (m == sim_mouse_log_count || sim_keyboard_log[k].time <= sim_mouse_log[m].time)) {
+            const report_keyboard_t *report = &sim_keyboard_log[k].report;
+            fprintf(out, "%6u kbd   %02X", (unsigned)sim_keyboard_log[k].time, report->mods);
+            for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+                fprintf(out, " %02X", report->keys[i]);
+            }
+            fputc('\n', out);
+            k++;
+        } else {
+            const report_mouse_t *report = &sim_mouse_log[m].report;
+            fprintf(out, "%6u mouse %02X %4d %4d %4d %4d\n", (unsigned)sim_mouse_log[m].time, report->buttons, report->x, report->y,
+                    report->v, report->h);
+            m++;
+        }
+    }
+}
+
+void trace_print_frame(FILE *out) {
+    for (uint8_t i = 0; i < RGB_MATRIX_LED_COUNT; i++) {
+        fprintf(out, "led %2u %3u %3u %3u\n", i, sim_leds[i].r, sim_leds[i].g, sim_leds[i].b);
+    }
+}
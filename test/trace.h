@@ -0,0 +1,39 @@
+#pragma once
+
+// Key traces for the host build. A trace is a text file of debounced key
+// events, one per line:
+//
+//     <time_ms> down|up <row> <col>
+//
+// Times are relative to the start of the replay and must not go backwards.
+// Rows 0-3 are the left half and 4-7 the right, as in the keymap matrix.
+// Blank lines and anything after '#' are ignored.
+
+#include "sim.h"
+#include <stdio.h>
+
+typedef struct {
+    uint32_t time;
+    uint8_t  row;
+    uint8_t  col;
+    bool     pressed;
+} trace_event_t;
+
+typedef struct {
+    trace_event_t *events;
+    size_t         count;
+} trace_t;
+
+// Returns false with a message on stderr if the file can't be read or parsed
+bool trace_load(const char *path, trace_t *trace);
+void trace_free(trace_t *trace);
+
+// Scans up to each event's time and injects it, then scans tail_ms more
+void trace_replay(const trace_t *trace, uint32_t tail_ms);
+
+// Keyboard and mouse reports since the last sim_clear_output(), one per line
+// in the order they were sent
+void trace_print_reports(FILE *out);
+
+// LED colors as last flushed, one per line
+void trace_print_frame(FILE *out);
@@ -0,0 +1,678 @@
+// Typing-efficiency analyzer for the keymap. Reads keymaps[] from keymap.c,
+// both the active layers and the commented-out alternatives, places every
+// key on an approximate Corne geometry, and scores how the layout types a
+// text corpus:
+//
+//   travel     key units the fingers move, from home and back, per keypress
+//   SFB        same-finger bigrams: two presses in a row by one finger on
+//              different keys
+//   layer sw   characters typed on a different layer than the previous one
+//   MO holds   MO() keys pressed to reach a layer
+//
+// all per 1000 characters typed. Each character is typed the cheapest way
+// the layout allows: fewest MO() holds, then without Shift, then least
+// travel. Held layers stay held while consecutive characters need them, and
+// Shift is a oneshot pressed for each shifted character. ARROW_R/L and other
+// custom keycodes don't type characters.
+//
+// Every alternative [N] block yields a candidate with that layer swapped in,
+// and all of them swapped in together if there are several. The corpus is
+// memory-mapped and split into 4 MB chunks, scored on one thread per core
+// or per chunk, whichever is fewer, so a small corpus runs on one thread.
+// The state before a chunk is recovered from the last typeable character
+// ahead of it, so the totals don't depend on the thread count.
+//
+//   layout_analyzer [-j threads] [-k keymap.c]... corpus-file-or-dir...
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LAYOUT_MACRO "LAYOUT_split_3x6_3"
+#define KEY_COUNT 42  // 3 rows of 2 x 6, then 2 x 3 thumbs
+#define MAX_LAYERS 16
+#define MAX_HOLDS 3
+#define MAX_LAYOUTS 32
+#define CHUNK_SIZE (4 << 20)
+
+// ============================================================================
+// GEOMETRY
+// ============================================================================
+
+// Keys in LAYOUT_split_3x6_3 argument order: three rows of the left half's
+// six columns then the right half's, outer to inner on the left and inner to
+// outer on the right, then the left thumbs outer to inner and the right
+// thumbs inner to outer. Positions are in key units.
+
+enum {
+    L_PINKY,
+    L_RING,
+    L_MIDDLE,
+    L_INDEX,
+    L_THUMB,
+    R_THUMB,
+    R_INDEX,
+    R_MIDDLE,
+    R_RING,
+    R_PINKY,
+    FINGER_COUNT,
+};
+
+typedef struct {
+    double  x, y;
+    uint8_t finger;
+} key_geometry_t;
+
+static key_geometry_t geometry[KEY_COUNT];
+static uint8_t        home[FINGER_COUNT];  // Key each finger rests on
+static double         press_travel[KEY_COUNT];
+
+static void geometry_init(void) {
+    // Column stagger of the left half, outer to inner, middle finger highest
+    static const double  stagger[6]       = {0.375, 0.375, 0.125, 0, 0.125, 0.25};
+    static const uint8_t left_fingers[6]  = {L_PINKY, L_PINKY, L_RING, L_MIDDLE, L_INDEX, L_INDEX};
+    static const uint8_t right_fingers[6] = {R_INDEX, R_INDEX, R_MIDDLE, R_RING, R_PINKY, R_PINKY};
+
+    for (uint8_t row = 0; row < 3; row++) {
+        for (uint8_t col = 0; col < 6; col++) {
+            geometry[row * 12 + col]     = (key_geometry_t){col, row + stagger[col], left_fingers[col]};
+            geometry[row * 12 + 6 + col] = (key_geometry_t){9 + col, row + stagger[5 - col], right_fingers[col]};
+        }
+    }
+    for (uint8_t t = 0; t < 3; t++) {
+        geometry[36 + t] = (key_geometry_t){3.5 + t, 3.5, L_THUMB};
+        geometry[39 + t] = (key_geometry_t){8.5 + t, 3.5, R_THUMB};
+    }
+
+    // Home row, and the middle thumb key
+    static const uint8_t homes[FINGER_COUNT] = {13, 14, 15, 16, 37, 40, 19, 20, 21, 22};
+    memcpy(home, homes, sizeof(home));
+    for (uint8_t k = 0; k < KEY_COUNT; k++) {
+        const key_geometry_t *h = &geometry[home[geometry[k].finger]];
+        press_travel[k]         = 2 * hypot(geometry[k].x - h->x, geometry[k].y - h->y);
+    }
+}
+
+// ============================================================================
+// KEYCODES
+// ============================================================================
+
+// Characters a keycode types on its own, and with Shift held
+static const struct {
+    const char *name;
+    char        plain, shifted;
+} keycode_chars[] = {
+    {"KC_1", '1', '!'},    {"KC_2", '2', '@'},    {"KC_3", '3', '#'},     {"KC_4", '4', '$'},    {"KC_5", '5', '%'},
+    {"KC_6", '6', '^'},    {"KC_7", '7', '&'},    {"KC_8", '8', '*'},     {"KC_9", '9', '('},    {"KC_0", '0', ')'},
+    {"KC_MINS", '-', '_'}, {"KC_EQL", '=', '+'},  {"KC_LBRC", '[', '{'},  {"KC_RBRC", ']', '}'}, {"KC_BSLS", '\\', '|'},
+    {"KC_SCLN", ';', ':'}, {"KC_QUOT", '\'', '"'}, {"KC_GRV", '`', '~'},  {"KC_COMM", ',', '<'}, {"KC_DOT", '.', '>'},
+    {"KC_SLSH", '/', '?'}, {"KC_SPC", ' ', 0},    {"KC_ENT", '\n', 0},    {"KC_TAB", '\t', 0},
+
+    // Shifted aliases, which QMK sends with Shift added
+    {"KC_EXLM", '!', 0}, {"KC_AT", '@', 0},   {"KC_HASH", '#', 0}, {"KC_DLR", '$', 0},  {"KC_PERC", '%', 0},
+    {"KC_CIRC", '^', 0}, {"KC_AMPR", '&', 0}, {"KC_ASTR", '*', 0}, {"KC_LPRN", '(', 0}, {"KC_RPRN", ')', 0},
+    {"KC_UNDS", '_', 0}, {"KC_PLUS", '+', 0}, {"KC_LCBR", '{', 0}, {"KC_RCBR", '}', 0}, {"KC_PIPE", '|', 0},
+    {"KC_COLN", ':', 0}, {"KC_DQUO", '"', 0}, {"KC_TILD", '~', 0}, {"KC_LABK", '<', 0}, {"KC_RABK", '>', 0},
+    {"KC_QUES", '?', 0},
+};
+
+static bool keycode_char(const char *name, char *plain, char *shifted) {
+    if (strncmp(name, "KC_", 3) == 0 && name[3] >= 'A' && name[3] <= 'Z' && name[4] == 0) {
+        *plain   = name[3] - 'A' + 'a';
+        *shifted = name[3];
+        return true;
+    }
+    for (size_t i = 0; i < sizeof(keycode_chars) / sizeof(keycode_chars[0]); i++) {
+        if (strcmp(name, keycode_chars[i].name) == 0) {
+            *plain   = keycode_chars[i].plain;
+            *shifted = keycode_chars[i].shifted;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool is_transparent(const char *name) {
+    return strcmp(name, "_______") == 0 || strcmp(name, "KC_TRNS") == 0 || strcmp(name, "KC_TRANSPARENT") == 0;
+}
+
+static bool is_shift(const char *name) {
+    return strcmp(name, "OS_SHFT") == 0 || strcmp(name, "KC_LSFT") == 0 || strcmp(name, "KC_RSFT") == 0 ||
+           strcmp(name, "OSM(MOD_LSFT)") == 0 || strcmp(name, "OSM(MOD_RSFT)") == 0;
+}
+
+// Layer of an MO(n), or -1
+static int momentary_layer(const char *name) {
+    int layer;
+    char end;
+    if (sscanf(name, "MO(%d%c", &layer, &end) == 2 && end == ')' && layer >= 0 && layer < MAX_LAYERS) return layer;
+    return -1;
+}
+
+// ============================================================================
+// KEYMAP PARSING
+// ============================================================================
+
+typedef struct {
+    char *keys[MAX_LAYERS][KEY_COUNT];  // Keycode names, NULL for absent layers
+    char  name[96];
+} layout_t;
+
+static layout_t layouts[MAX_LAYOUTS];
+static int      layout_count = 0;
+
+static char *read_file(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *text = malloc(size + 1);
+    text[fread(text, 1, size, file)] = 0;
+    fclose(file);
+    return text;
+}
+
+static void append(char **buffer, size_t *length, const char *text, size_t count) {
+    *buffer = realloc(*buffer, *length + count + 2);
+    memcpy(*buffer + *length, text, count);
+    *length += count;
+    (*buffer)[(*length)++] = '\n';
+    (*buffer)[*length]     = 0;
+}
+
+// Length of a line with any // comment cut off
+static size_t code_length(const char *line, size_t length) {
+    for (size_t i = 0; i + 1 < length; i++) {
+        if (line[i] == '/' && line[i + 1] == '/') return i;
+    }
+    return length;
+}
+
+// Splits the keymaps[] table into the active code and the commented-out
+// code: lines behind a single //, with comments inside them (// //)
+// dropped
+static bool split_keymaps(const char *text, char **active, char **commented) {
+    const char *start = strstr(text, "keymaps[]");
+    if (!start) return false;
+    size_t active_length = 0, commented_length = 0;
+    *active = *commented = NULL;
+    append(active, &active_length, "", 0);
+    append(commented, &commented_length, "", 0);
+
+    for (const char *line = start; *line;) {
+        const char *end    = strchr(line, '\n');
+        size_t      length = end ? (size_t)(end - line) : strlen(line);
+        if (strncmp(line, "};", 2) == 0) break;
+
+        const char *p = line;
+        while (p < line + length && (*p == ' ' || *p == '\t')) p++;
+        if (p + 1 < line + length && p[0] == '/' && p[1] == '/') {
+            p += 2;
+            while (p < line + length && (*p == ' ' || *p == '\t')) p++;
+            size_t rest = line + length - p;
+            append(commented, &commented_length, p, code_length(p, rest));
+        } else {
+            append(active, &active_length, line, code_length(line, length));
+        }
+        line = end ? end + 1 : line + length;
+    }
+    return true;
+}
+
+static char *trim(char *s) {
+    while (*s == ' ' || *s == '\t' || *s == '\n') s++;
+    char *end = s + strlen(s);
+    while (end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\n')) *--end = 0;
+    return s;
+}
+
+typedef struct {
+    int   layer;
+    char *keys[KEY_COUNT];
+} layer_block_t;
+
+// Finds the next "[N] = LAYOUT_split_3x6_3(...)" in code and splits its
+// arguments. Returns the position after it, or NULL when there is none.
+static const char *parse_block(const char *code, layer_block_t *block, const char *path) {
+    for (const char *macro = strstr(code, LAYOUT_MACRO); macro; macro = strstr(macro + 1, LAYOUT_MACRO)) {
+        // Walk back over "] =" to the layer index
+        const char *p = macro;
+        while (p > code && (p[-1] == ' ' || p[-1] == '\t' || p[-1] == '\n' || p[-1] == '=')) p--;
+        if (p == code || p[-1] != ']') continue;
+        const char *open = p - 1;
+        while (open > code && open[-1] != '[') open--;
+        if (open == code || sscanf(open, "%d", &block->layer) != 1 || block->layer < 0 || block->layer >= MAX_LAYERS) continue;
+
+        const char *args = strchr(macro, '(');
+        if (!args) return NULL;
+        int         depth = 0, count = 0;
+        const char *arg   = args + 1;
+        for (const char *c = args + 1; *c; c++) {
+            if (*c == '(') depth++;
+            if (*c == ')' && depth-- == 0) {
+                if (count < KEY_COUNT) block->keys[count] = trim(strndup(arg, c - arg));
+                count++;
+                if (count != KEY_COUNT) {
+                    fprintf(stderr, "%s: layer %d has %d keys, %s takes %d\n", path, block->layer, count, LAYOUT_MACRO, KEY_COUNT);
+                    exit(1);
+                }
+                return c + 1;
+            }
+            if (*c == ',' && depth == 0) {
+                if (count < KEY_COUNT) block->keys[count] = trim(strndup(arg, c - arg));
+                count++;
+                arg = c + 1;
+            }
+        }
+        return NULL;
+    }
+    return NULL;
+}
+
+static layout_t *add_layout(const char *name) {
+    if (layout_count == MAX_LAYOUTS) {
+        fprintf(stderr, "More than %d layouts\n", MAX_LAYOUTS);
+        exit(1);
+    }
+    layout_t *layout = &layouts[layout_count++];
+    snprintf(layout->name, sizeof(layout->name), "%s", name);
+    return layout;
+}
+
+// Adds the keymap as it is, then one candidate per commented-out layer and
+// one with all of them
+static void load_keymap(const char *path) {
+    char *text = read_file(path);
+    char *active, *commented;
+    if (!text || !split_keymaps(text, &active, &commented)) {
+        fprintf(stderr, "%s: no keymaps[] table\n", path);
+        exit(1);
+    }
+
+    layout_t     *base = add_layout(path);
+    layer_block_t block;
+    for (const char *p = active; (p = parse_block(p, &block, path));) {
+        memcpy(base->keys[block.layer], block.keys, sizeof(block.keys));
+    }
+    if (!base->keys[0][0]) {
+        fprintf(stderr, "%s: no layer 0\n", path);
+        exit(1);
+    }
+
+    layout_t  combined = *base;
+    char      layers[64] = "";
+    int       alternatives = 0;
+    for (const char *p = commented; (p = parse_block(p, &block, path));) {
+        char name[96];
+        snprintf(name, sizeof(name), "%s alt [%d]", path, block.layer);
+        layout_t *candidate = add_layout(name);
+        memcpy(candidate->keys, base->keys, sizeof(base->keys));
+        memcpy(candidate->keys[block.layer], block.keys, sizeof(block.keys));
+        memcpy(combined.keys[block.layer], block.keys, sizeof(block.keys));
+        snprintf(layers + strlen(layers), sizeof(layers) - strlen(layers), "%s[%d]", alternatives ? " " : "", block.layer);
+        alternatives++;
+    }
+    if (alternatives > 1) {
+        snprintf(combined.name, sizeof(combined.name), "%s alt %s", path, layers);
+        *add_layout(combined.name) = combined;
+    }
+    free(text);
+    free(active);
+    free(commented);
+}
+
+// ============================================================================
+// TYPING PLANS
+// ============================================================================
+
+// How a character is typed: keys held for its layer, then Shift if needed,
+// then the key
+typedef struct {
+    bool    typeable;
+    uint8_t layer;
+    uint8_t hold_count;
+    uint8_t holds[MAX_HOLDS];
+    int8_t  shift;  // Key, or -1
+    uint8_t key;
+} plan_t;
+
+// What typing a character costs after a given one, so scoring is one table
+// lookup per byte. Row 256 is for the first character of a file.
+typedef struct {
+    float   travel;
+    uint8_t presses, holds, sfb, layer_switch;
+} transition_t;
+
+typedef struct {
+    plan_t       plans[256];
+    transition_t next[257][256];
+} compiled_t;
+
+static compiled_t compiled[MAX_LAYOUTS];
+
+// Layers reachable through MO() keys, with the keys held to get there
+typedef struct {
+    uint8_t stack[MAX_HOLDS + 1];  // Active layers, lowest first
+    uint8_t holds[MAX_HOLDS];
+    uint8_t hold_count;
+} layer_state_t;
+
+// Keycode at key with the stack active, falling through transparent keys
+static const char *resolve(const layout_t *layout, const layer_state_t *state, uint8_t key) {
+    for (int i = state->hold_count; i >= 0; i--) {
+        const char *name = layout->keys[state->stack[i]][key];
+        if (name && !is_transparent(name)) return name;
+    }
+    return "KC_NO";
+}
+
+static bool is_held(const layer_state_t *state, uint8_t key) {
+    for (uint8_t i = 0; i < state->hold_count; i++) {
+        if (state->holds[i] == key) return true;
+    }
+    return false;
+}
+
+static bool better(const plan_t *a, const plan_t *b) {
+    if (!b->typeable) return true;
+    if (a->hold_count != b->hold_count) return a->hold_count < b->hold_count;
+    if ((a->shift >= 0) != (b->shift >= 0)) return a->shift < 0;
+    double ta = press_travel[a->key] + (a->shift >= 0 ? press_travel[a->shift] : 0);
+    double tb = press_travel[b->key] + (b->shift >= 0 ? press_travel[b->shift] : 0);
+    return ta < tb;
+}
+
+// Shift key for a character key: another finger if possible, then the
+// least travel
+static int find_shift(const layout_t *layout, const layer_state_t *state, uint8_t key) {
+    int best = -1;
+    for (uint8_t k = 0; k < KEY_COUNT; k++) {
+        if (k == key || is_held(state, k) || !is_shift(resolve(layout, state, k))) continue;
+        if (best < 0) {
+            best = k;
+            continue;
+        }
+        bool other = geometry[k].finger != geometry[key].finger, best_other = geometry[best].finger != geometry[key].finger;
+        if (other != best_other ? other : press_travel[k] < press_travel[best]) best = k;
+    }
+    return best;
+}
+
+static void offer(plan_t *plans, const layer_state_t *state, uint8_t c, uint8_t key, int shift) {
+    plan_t plan = {
+        .typeable   = true,
+        .layer      = state->stack[state->hold_count],
+        .hold_count = state->hold_count,
+        .shift      = shift,
+        .key        = key,
+    };
+    memcpy(plan.holds, state->holds, sizeof(plan.holds));
+    if (better(&plan, &plans[c])) plans[c] = plan;
+}
+
+static void press(transition_t *t, int *last, uint8_t key) {
+    t->presses++;
+    t->travel += press_travel[key];
+    if (*last >= 0 && *last != key && geometry[*last].finger == geometry[key].finger) t->sfb++;
+    *last = key;
+}
+
+// Holds still down from the previous character stay down; the rest are
+// pressed, then Shift, then the key
+static transition_t transition(const plan_t *prev, const plan_t *plan) {
+    transition_t t    = {0};
+    int          last = prev ? prev->key : -1;
+    uint8_t      kept = 0;
+    if (prev) {
+        while (kept < plan->hold_count && kept < prev->hold_count && plan->holds[kept] == prev->holds[kept]) kept++;
+    }
+    t.layer_switch = plan->layer != (prev ? prev->layer : 0);
+    for (uint8_t h = kept; h < plan->hold_count; h++) {
+        press(&t, &last, plan->holds[h]);
+        t.holds++;
+    }
+    if (plan->shift >= 0) press(&t, &last, plan->shift);
+    press(&t, &last, plan->key);
+    return t;
+}
+
+static void compile(const layout_t *layout, compiled_t *out) {
+    layer_state_t states[64];
+    int           state_count = 1;
+    states[0]                 = (layer_state_t){.stack = {0}};
+
+    // Breadth first, so fewer holds come first
+    for (int s = 0; s < state_count; s++) {
+        layer_state_t *state = &states[s];
+        if (state->hold_count == MAX_HOLDS) continue;
+        for (uint8_t k = 0; k < KEY_COUNT; k++) {
+            int layer = momentary_layer(resolve(layout, state, k));
+            if (layer < 0 || !layout->keys[layer][0] || is_held(state, k)) continue;
+            bool active = false;
+            for (uint8_t i = 0; i <= state->hold_count; i++) active |= state->stack[i] == layer;
+            if (active || state_count == 64) continue;
+
+            layer_state_t next                = *state;
+            next.holds[next.hold_count++]     = k;
+            next.stack[next.hold_count]       = layer;
+            states[state_count++]             = next;
+        }
+    }
+
+    memset(out, 0, sizeof(*out));
+    for (int s = 0; s < state_count; s++) {
+        for (uint8_t k = 0; k < KEY_COUNT; k++) {
+            char plain, shifted;
+            if (is_held(&states[s], k) || !keycode_char(resolve(layout, &states[s], k), &plain, &shifted)) continue;
+            offer(out->plans, &states[s], plain, k, -1);
+            if (shifted) {
+                int shift = find_shift(layout, &states[s], k);
+                if (shift >= 0) offer(out->plans, &states[s], shifted, k, shift);
+            }
+        }
+    }
+
+    for (uint16_t p = 0; p <= 256; p++) {
+        const plan_t *prev = p < 256 && out->plans[p].typeable ? &out->plans[p] : NULL;
+        if (p < 256 && !prev) continue;
+        for (uint16_t c = 0; c < 256; c++) {
+            if (out->plans[c].typeable) out->next[p][c] = transition(prev, &out->plans[c]);
+        }
+    }
+}
+
+// ============================================================================
+// SCORING
+// ============================================================================
+
+typedef struct {
+    uint64_t typed, untyped, presses, sfb, layer_switches, holds;
+    double   travel;
+} stats_t;
+
+typedef struct {
+    const uint8_t *data;
+    size_t         size;
+} corpus_file_t;
+
+typedef struct {
+    uint32_t file;
+    size_t   start, end;
+} chunk_t;
+
+static corpus_file_t *files;
+static size_t         file_count;
+static chunk_t       *chunks;
+static size_t         chunk_count;
+static size_t         next_chunk = 0;
+
+static void score(const compiled_t *layout, const uint8_t *data, size_t start, size_t end, stats_t *stats) {
+    // Everything before the chunk that matters is its last typeable character
+    uint16_t prev = 256;
+    for (size_t i = start; i-- > 0;) {
+        if (layout->plans[data[i]].typeable) {
+            prev = data[i];
+            break;
+        }
+    }
+
+    uint64_t typed = 0, untyped = 0, presses = 0, sfb = 0, layer_switches = 0, holds = 0;
+    double   travel = 0;
+    for (size_t i = start; i < end; i++) {
+        uint8_t c = data[i];
+        if (!layout->plans[c].typeable) {
+            untyped += c != '\r';
+            continue;
+        }
+        const transition_t *t = &layout->next[prev][c];
+        typed++;
+        travel += t->travel;
+        presses += t->presses;
+        holds += t->holds;
+        sfb += t->sfb;
+        layer_switches += t->layer_switch;
+        prev = c;
+    }
+    stats->typed += typed;
+    stats->untyped += untyped;
+    stats->presses += presses;
+    stats->sfb += sfb;
+    stats->layer_switches += layer_switches;
+    stats->holds += holds;
+    stats->travel += travel;
+}
+
+static void *worker(void *arg) {
+    stats_t *stats = arg;
+    for (;;) {
+        size_t index = __atomic_fetch_add(&next_chunk, 1, __ATOMIC_RELAXED);
+        if (index >= chunk_count) return NULL;
+        const chunk_t *chunk = &chunks[index];
+        for (int l = 0; l < layout_count; l++) {
+            score(&compiled[l], files[chunk->file].data, chunk->start, chunk->end, &stats[l]);
+        }
+    }
+}
+
+// ============================================================================
+// CORPUS
+// ============================================================================
+
+static uint64_t total_bytes = 0;
+
+static int add_file(const char *path, const struct stat *st, int type, struct FTW *ftw) {
+    if (type != FTW_F || !S_ISREG(st->st_mode) || st->st_size == 0) return 0;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return 0;
+    }
+    void *data = mmap(NULL, st->st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return 0;
+    }
+    madvise(data, st->st_size, MADV_SEQUENTIAL);
+
+    files                = realloc(files, (file_count + 1) * sizeof(*files));
+    files[file_count]    = (corpus_file_t){data, st->st_size};
+    for (size_t start = 0; start < (size_t)st->st_size; start += CHUNK_SIZE) {
+        size_t end          = start + CHUNK_SIZE < (size_t)st->st_size ? start + CHUNK_SIZE : (size_t)st->st_size;
+        chunks              = realloc(chunks, (chunk_count + 1) * sizeof(*chunks));
+        chunks[chunk_count++] = (chunk_t){file_count, start, end};
+    }
+    file_count++;
+    total_bytes += st->st_size;
+    return 0;
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+static double seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: layout_analyzer [-j threads] [-k keymap.c]... corpus-file-or-dir...\n");
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    long threads  = sysconf(_SC_NPROCESSORS_ONLN);
+    bool keymaps  = false;
+    int  opt;
+    geometry_init();
+    while ((opt = getopt(argc, argv, "j:k:")) != -1) {
+        switch (opt) {
+            case 'j':
+                threads = atol(optarg);
+                break;
+            case 'k':
+                load_keymap(optarg);
+                keymaps = true;
+                break;
+            default:
+                usage();
+        }
+    }
+    if (optind == argc || threads < 1) usage();
+    if (!keymaps) load_keymap("keymap.c");
+
+    for (int l = 0; l < layout_count; l++) compile(&layouts[l], &compiled[l]);
+    for (int i = optind; i < argc; i++) {
+        if (nftw(argv[i], add_file, 16, FTW_PHYS) != 0) {
+            fprintf(stderr, "%s: %s\n", argv[i], strerror(errno));
+            return 1;
+        }
+    }
+
+    // A thread per chunk at most; the rest would find nothing to score
+    if ((size_t)threads > chunk_count) threads = chunk_count ? chunk_count : 1;
+
+    double     start   = seconds();
+    pthread_t *tids    = calloc(threads, sizeof(*tids));
+    stats_t   *partial = calloc(threads * layout_count, sizeof(*partial));
+    for (long t = 0; t < threads; t++) pthread_create(&tids[t], NULL, worker, &partial[t * layout_count]);
+    for (long t = 0; t < threads; t++) pthread_join(tids[t], NULL);
+    double elapsed = seconds() - start;
+
+    printf("%-32s %12s %9s %10s %8s %10s %9s\n", "layout", "chars", "untyped", "travel/1k", "SFB/1k", "layer sw/1k", "MO/1k");
+    for (int l = 0; l < layout_count; l++) {
+        stats_t sum = {0};
+        for (long t = 0; t < threads; t++) {
+            const stats_t *s = &partial[t * layout_count + l];
+            sum.typed += s->typed;
+            sum.untyped += s->untyped;
+            sum.presses += s->presses;
+            sum.sfb += s->sfb;
+            sum.layer_switches += s->layer_switches;
+            sum.holds += s->holds;
+            sum.travel += s->travel;
+        }
+        double per_1k = sum.typed ? 1000.0 / sum.typed : 0;
+        printf("%-32s %12llu %9llu %10.1f %8.1f %11.1f %9.1f\n", layouts[l].name, (unsigned long long)sum.typed,
+               (unsigned long long)sum.untyped, sum.travel * per_1k, sum.sfb * per_1k, sum.layer_switches * per_1k,
+               sum.holds * per_1k);
+    }
+    fprintf(stderr, "%zu files, %.1f MB in %zu chunks, %.2f s on %ld threads (%.0f MB/s)\n", file_count, total_bytes / 1e6,
+            chunk_count, elapsed, threads, total_bytes / 1e6 / elapsed);
+    return 0;
+}